@@ -0,0 +1,276 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "AlignmentCache.h"
+#include <hcsrc/FileReader.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+AlignmentCache *AlignmentCache::_cache = NULL;
+
+AlignmentCache *AlignmentCache::cache()
+{
+	static std::mutex creation;
+	std::lock_guard<std::mutex> lock(creation);
+
+	if (_cache == NULL)
+	{
+		_cache = new AlignmentCache();
+	}
+
+	return _cache;
+}
+
+AlignmentCache::AlignmentCache()
+{
+
+}
+
+/* FNV-1a, so that hashes stay the same between sessions and builds */
+unsigned long long AlignmentCache::hash(const std::string &str)
+{
+	unsigned long long h = 14695981039346656037ULL;
+	
+	for (size_t i = 0; i < str.length(); i++)
+	{
+		h ^= (unsigned char)str[i];
+		h *= 1099511628211ULL;
+	}
+
+	return h;
+}
+
+bool AlignmentCache::KeyLess::operator()(const Key &a, const Key &b) const
+{
+	if (a.resultHash != b.resultHash)
+	{
+		return a.resultHash < b.resultHash;
+	}
+	if (a.refHash != b.refHash)
+	{
+		return a.refHash < b.refHash;
+	}
+	if (a.offset != b.offset)
+	{
+		return a.offset < b.offset;
+	}
+	if (a.diagonal != b.diagonal)
+	{
+		return a.diagonal < b.diagonal;
+	}
+
+	return a.mode < b.mode;
+}
+
+AlignmentCache::Key AlignmentCache::makeKey(const std::string &ref, 
+                                            const std::string &result,
+                                            int offset, int diagonal, 
+                                            int mode)
+{
+	Key key;
+	key.refHash = hash(ref);
+	key.resultHash = hash(result);
+	key.offset = offset;
+	key.diagonal = diagonal;
+	key.mode = mode;
+	return key;
+}
+
+bool AlignmentCache::fetch(const std::string &ref, const std::string &result,
+                           int offset, int diagonal, int mode, 
+                           CachedAlignment *out)
+{
+	Key key = makeKey(ref, result, offset, diagonal, mode);
+	std::lock_guard<std::mutex> lock(_mutex);
+	
+	std::map<Key, Entry, KeyLess>::iterator it = _entries.find(key);
+	
+	/* guard against hash collisions on the (much more varied) result */
+	if (it == _entries.end() || it->second.result != result)
+	{
+		return false;
+	}
+	
+	*out = it->second.alignment;
+	return true;
+}
+
+void AlignmentCache::store(const std::string &ref, const std::string &result,
+                           int offset, int diagonal, int mode, 
+                           const CachedAlignment &entry)
+{
+	Key key = makeKey(ref, result, offset, diagonal, mode);
+	Entry e;
+	e.result = result;
+	e.alignment = entry;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	insert(key, e);
+}
+
+void AlignmentCache::insert(const Key &key, const Entry &e)
+{
+	std::map<Key, Entry, KeyLess>::iterator it = _entries.find(key);
+	
+	if (it != _entries.end())
+	{
+		it->second = e;
+		return;
+	}
+
+	while (_entries.size() >= _maxEntries && _order.size())
+	{
+		_entries.erase(_order.front());
+		_order.pop_front();
+	}
+
+	_entries[key] = e;
+	_order.push_back(key);
+}
+
+size_t AlignmentCache::size()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _entries.size();
+}
+
+void AlignmentCache::clear()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_entries.clear();
+	_order.clear();
+}
+
+/* each entry is six lines: the key, then result, left, align and right
+ * (which contain spaces but never new lines), then the mutations */
+
+bool AlignmentCache::save(std::string filename)
+{
+	std::ofstream file;
+	file.open(filename);
+	
+	if (!file.is_open())
+	{
+		std::cout << "Could not write alignment cache to " 
+		<< filename << std::endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	std::map<Key, Entry, KeyLess>::iterator it;
+
+	for (it = _entries.begin(); it != _entries.end(); it++)
+	{
+		const Key &k = it->first;
+		const CachedAlignment &a = it->second.alignment;
+
+		file << ">" << k.refHash << " " << k.resultHash << " " << k.offset
+		<< " " << k.mode << " " << (a.problematic ? 1 : 0) << " " 
+		<< k.diagonal << std::endl;
+		file << it->second.result << std::endl;
+		file << a.left << std::endl;
+		file << a.align << std::endl;
+		file << a.right << std::endl;
+
+		for (size_t i = 0; i < a.mutations.size(); i++)
+		{
+			file << mutation_string(a.mutations[i]) << " ";
+		}
+		file << std::endl;
+	}
+	
+	file.close();
+
+	std::cout << "Saved " << _entries.size() << " cached alignments to "
+	<< filename << std::endl;
+
+	return true;
+}
+
+bool AlignmentCache::load(std::string filename)
+{
+	std::ifstream file;
+	file.open(filename);
+	
+	if (!file.is_open())
+	{
+		std::cout << "No alignment cache at " << filename << std::endl;
+		return false;
+	}
+	
+	std::lock_guard<std::mutex> lock(_mutex);
+	std::string line;
+	int count = 0;
+	
+	while (std::getline(file, line))
+	{
+		if (line.length() == 0 || line[0] != '>')
+		{
+			continue;
+		}
+
+		Key key;
+		int problematic = 0;
+		std::istringstream ss(line.substr(1));
+		ss >> key.refHash >> key.resultHash >> key.offset >> key.mode
+		>> problematic;
+		
+		/* older caches did not record the diagonal */
+		key.diagonal = 0;
+		bool known = !ss.fail() && (ss >> key.diagonal);
+
+		Entry e;
+		std::string muts;
+		if (ss.fail() ||
+		    !std::getline(file, e.result) ||
+		    !std::getline(file, e.alignment.left) ||
+		    !std::getline(file, e.alignment.align) ||
+		    !std::getline(file, e.alignment.right) ||
+		    !std::getline(file, muts))
+		{
+			break;
+		}
+		
+		/* entry is corrupt, or its alignment settings are unknown */
+		if (key.resultHash != hash(e.result) || !known)
+		{
+			continue;
+		}
+
+		e.alignment.problematic = (problematic != 0);
+		std::vector<std::string> bits = split(muts, ' ');
+
+		for (size_t i = 0; i < bits.size(); i++)
+		{
+			Mutation m;
+			if (mutation_from_string(bits[i], &m))
+			{
+				e.alignment.mutations.push_back(m);
+			}
+		}
+
+		insert(key, e);
+		count++;
+	}
+	
+	std::cout << "Loaded " << count << " cached alignments from "
+	<< filename << std::endl;
+
+	return true;
+}
@@ -0,0 +1,100 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__alignmentcache__
+#define __breathalyser__alignmentcache__
+
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <mutex>
+#include "Mutation.h"
+
+/* remembers the outcome of careful comparisons, keyed by the contents of
+ * the reference and the translated sequence, so that identical proteins
+ * are only ever aligned once (and optionally, once across sessions). 
+ * Holds a bounded number of alignments, forgetting the oldest first. */
+
+typedef struct
+{
+	std::vector<Mutation> mutations;
+	std::string left;
+	std::string align;
+	std::string right;
+	bool problematic;
+} CachedAlignment;
+
+class AlignmentCache
+{
+public:
+	static AlignmentCache *cache();
+
+	/* offset, diagonal and mode (alignment settings) are part of the key 
+	 * as they change the reported mutations */
+	bool fetch(const std::string &ref, const std::string &result, 
+	           int offset, int diagonal, int mode, CachedAlignment *out);
+	void store(const std::string &ref, const std::string &result, 
+	           int offset, int diagonal, int mode, 
+	           const CachedAlignment &entry);
+
+	bool load(std::string filename);
+	bool save(std::string filename);
+	void clear();
+	
+	size_t size();
+private:
+	AlignmentCache();
+
+	typedef struct
+	{
+		unsigned long long refHash;
+		unsigned long long resultHash;
+		int offset;
+		int diagonal;
+		int mode;
+	} Key;
+	
+	struct KeyLess
+	{
+		bool operator()(const Key &a, const Key &b) const;
+	};
+	
+	typedef struct
+	{
+		std::string result;
+		CachedAlignment alignment;
+	} Entry;
+
+	static unsigned long long hash(const std::string &str);
+	static Key makeKey(const std::string &ref, const std::string &result,
+	                   int offset, int diagonal, int mode);
+	
+	/* called with the lock held */
+	void insert(const Key &key, const Entry &e);
+
+	static const size_t _maxEntries = 200000;
+
+	std::map<Key, Entry, KeyLess> _entries;
+	std::deque<Key> _order;
+	std::mutex _mutex;
+
+	static AlignmentCache *_cache;
+};
+
+#endif
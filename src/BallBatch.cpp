@@ -0,0 +1,211 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "BallBatch.h"
+#include <h3dsrc/shaders/vStructure.h>
+#include <h3dsrc/shaders/fStructure.h>
+#include <cfloat>
+
+BallBatch::BallBatch() : Icosahedron()
+{
+	triangulate();
+
+	_templateVertices = _vertices;
+	_templateIndices = _indices;
+	_templateCentre = centroid();
+	_vertices.clear();
+	_indices.clear();
+
+	_renderType = GL_TRIANGLES;
+	_vString = Structure_vsh();
+	_fString = Structure_fsh();
+	_selectedBall = -1;
+	_dirty = false;
+	setSelectable(true);
+	this->SlipObject::setName("Ball batch");
+}
+
+BallBatch::~BallBatch()
+{
+
+}
+
+void BallBatch::setSlotCount(size_t count)
+{
+	Ball empty;
+	empty.present = false;
+	empty.scale = 0;
+	_balls.resize(count, empty);
+}
+
+void BallBatch::setBall(size_t slot, vec3 pos, double scale, vec3 colour)
+{
+	if (slot >= _balls.size())
+	{
+		setSlotCount(slot + 1);
+	}
+
+	Ball &b = _balls[slot];
+	b.pos = pos;
+	b.scale = scale;
+	b.colour = colour;
+	b.present = true;
+	_dirty = true;
+}
+
+void BallBatch::removeBall(size_t slot)
+{
+	if (!hasBall(slot))
+	{
+		return;
+	}
+
+	_balls[slot].present = false;
+	
+	if (_selectedBall == (int)slot)
+	{
+		_selectedBall = -1;
+	}
+
+	_dirty = true;
+}
+
+void BallBatch::clearBalls()
+{
+	_balls.clear();
+	_selectedBall = -1;
+	_dirty = true;
+}
+
+void BallBatch::setSelectedBall(int slot)
+{
+	if (slot != _selectedBall)
+	{
+		_selectedBall = slot;
+		_dirty = true;
+	}
+}
+
+void BallBatch::rebuild()
+{
+	_vertices.clear();
+	_indices.clear();
+
+	for (size_t i = 0; i < _balls.size(); i++)
+	{
+		const Ball &b = _balls[i];
+
+		if (!b.present)
+		{
+			continue;
+		}
+		
+		vec3 colour = b.colour;
+		
+		if ((int)i == _selectedBall)
+		{
+			/* wash out towards white */
+			colour.x = (colour.x + 1) / 2;
+			colour.y = (colour.y + 1) / 2;
+			colour.z = (colour.z + 1) / 2;
+		}
+
+		GLuint begin = _vertices.size();
+
+		for (size_t j = 0; j < _templateVertices.size(); j++)
+		{
+			Helen3D::Vertex v = _templateVertices[j];
+			vec3 p = vec_from_pos(v.pos);
+			vec3_subtract_from_vec3(&p, _templateCentre);
+			vec3_mult(&p, b.scale);
+			vec3_add_to_vec3(&p, b.pos);
+			pos_from_vec(v.pos, p);
+			
+			v.color[0] = colour.x;
+			v.color[1] = colour.y;
+			v.color[2] = colour.z;
+			v.color[3] = 1;
+
+			_vertices.push_back(v);
+		}
+
+		for (size_t j = 0; j < _templateIndices.size(); j++)
+		{
+			_indices.push_back(begin + _templateIndices[j]);
+		}
+	}
+
+	_dirty = false;
+}
+
+void BallBatch::render(SlipGL *gl)
+{
+	if (_dirty)
+	{
+		rebuild();
+	}
+
+	if (_indices.size() == 0)
+	{
+		return;
+	}
+
+	Icosahedron::render(gl);
+}
+
+/* tests one ball at a time against the cursor, using this object's own
+ * transformation from the last render */
+int BallBatch::ballAt(double x, double y)
+{
+	if (_dirty)
+	{
+		rebuild();
+	}
+
+	std::vector<Helen3D::Vertex> all;
+	std::vector<GLuint> indices;
+	all.swap(_vertices);
+	indices.swap(_indices);
+	_indices = _templateIndices;
+
+	int which = -1;
+	double z = -FLT_MAX;
+	size_t per = _templateVertices.size();
+	size_t begin = 0;
+
+	for (size_t i = 0; i < _balls.size(); i++)
+	{
+		if (!_balls[i].present)
+		{
+			continue;
+		}
+
+		_vertices.assign(all.begin() + begin, all.begin() + begin + per);
+		begin += per;
+
+		if (intersects(x, y, &z))
+		{
+			which = i;
+		}
+	}
+	
+	_vertices.swap(all);
+	_indices.swap(indices);
+
+	return which;
+}
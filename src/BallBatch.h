@@ -0,0 +1,70 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__ballbatch__
+#define __breathalyser__ballbatch__
+
+#include <h3dsrc/Icosahedron.h>
+#include <vector>
+
+/* every mutation ball of an ensemble as one mesh, drawn in a single call.
+ * Balls are copies of one triangulated icosahedron, placed, scaled and
+ * coloured per slot; the mesh is rebuilt once after any changes. */
+
+class BallBatch : public Icosahedron
+{
+public:
+	BallBatch();
+	virtual ~BallBatch();
+
+	void setSlotCount(size_t count);
+	void setBall(size_t slot, vec3 pos, double scale, vec3 colour);
+	void removeBall(size_t slot);
+	void clearBalls();
+
+	bool hasBall(size_t slot)
+	{
+		return slot < _balls.size() && _balls[slot].present;
+	}
+
+	/* slot of the front-most ball under the cursor, or -1 */
+	int ballAt(double x, double y);
+	void setSelectedBall(int slot);
+
+	virtual void render(SlipGL *gl);
+private:
+	typedef struct
+	{
+		vec3 pos;
+		double scale;
+		vec3 colour;
+		bool present;
+	} Ball;
+
+	void rebuild();
+
+	std::vector<Helen3D::Vertex> _templateVertices;
+	std::vector<GLuint> _templateIndices;
+	vec3 _templateCentre;
+
+	std::vector<Ball> _balls;
+	int _selectedBall;
+	bool _dirty;
+};
+
+#endif
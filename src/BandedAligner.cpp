@@ -0,0 +1,306 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "BandedAligner.h"
+#include <algorithm>
+
+#define MATCH_SCORE 4
+#define MISMATCH_SCORE -2
+#define GAP_OPEN 8
+#define GAP_EXTEND 1
+#define UNREACHABLE -100000000
+
+/* which matrix a cell was reached from */
+enum
+{
+	FromStart,
+	FromMatch,
+	FromInsert,
+	FromDelete
+};
+
+BandedAligner::BandedAligner(const std::string &seq, const std::string &ref,
+                             int diagonal)
+{
+	_seq = seq;
+	_ref = ref;
+	_diagonal = diagonal;
+	_width = 0;
+}
+
+int BandedAligner::score(char a, char b)
+{
+	/* unknown residues shouldn't pull the alignment either way */
+	if (a == ' ' || b == ' ')
+	{
+		return 0;
+	}
+
+	return (a == b ? MATCH_SCORE : MISMATCH_SCORE);
+}
+
+void BandedAligner::addColumn(char l, char a, char r, int index)
+{
+	_left.push_back(l);
+	_align.push_back(a);
+	_right.push_back(r);
+	_indices.push_back(index);
+}
+
+bool BandedAligner::run(int width, int maxWidth)
+{
+	int n = _seq.length();
+	int m = _ref.length();
+
+	/* the end of both sequences must be reachable from the diagonal */
+	int spread = std::abs(n - m - _diagonal);
+
+	if (width < spread / 2)
+	{
+		width = spread / 2;
+	}
+
+	while (width <= maxWidth && width <= std::max(n, m))
+	{
+		if (alignWithin(width))
+		{
+			_width = width;
+			return true;
+		}
+
+		width *= 2;
+	}
+
+	return false;
+}
+
+bool BandedAligner::alignWithin(int w)
+{
+	int n = _seq.length();
+	int m = _ref.length();
+	int cols = 2 * w + 1;
+	int low = _diagonal - w;
+	size_t cells = (size_t)(n + 1) * cols;
+	
+	/* band cell (i, k) is sequence i against reference j = i - low - k */
+	std::vector<int> match(cells, UNREACHABLE);
+	std::vector<int> insert(cells, UNREACHABLE);
+	std::vector<int> del(cells, UNREACHABLE);
+	std::vector<unsigned char> trace(cells, 0);
+	
+	int best = UNREACHABLE;
+	int bestI = -1;
+	int bestK = -1;
+
+	for (int i = 0; i <= n; i++)
+	{
+		/* deletions look along the same row, so go right to left */
+		for (int k = cols - 1; k >= 0; k--)
+		{
+			int j = i - low - k;
+			
+			if (j < 0 || j > m)
+			{
+				continue;
+			}
+
+			size_t here = (size_t)i * cols + k;
+			unsigned char tr = 0;
+
+			if (i == 0 || j == 0)
+			{
+				/* overhangs at the start are free */
+				match[here] = 0;
+				tr = FromStart;
+			}
+			else
+			{
+				size_t prev = here - cols;
+				int s = score(_seq[i - 1], _ref[j - 1]);
+				int from = match[prev];
+				tr = FromMatch;
+
+				if (insert[prev] > from)
+				{
+					from = insert[prev];
+					tr = FromInsert;
+				}
+
+				if (del[prev] > from)
+				{
+					from = del[prev];
+					tr = FromDelete;
+				}
+				
+				if (from > UNREACHABLE)
+				{
+					match[here] = from + s;
+				}
+				
+				/* sequence residue against a gap: k - 1 on the row above */
+				if (k > 0)
+				{
+					size_t up = prev - 1;
+					int open = match[up] - GAP_OPEN;
+					int extend = insert[up] - GAP_EXTEND;
+					
+					if (open >= extend && match[up] > UNREACHABLE)
+					{
+						insert[here] = open;
+					}
+					else if (insert[up] > UNREACHABLE)
+					{
+						insert[here] = extend;
+						tr |= 1 << 2;
+					}
+				}
+
+				/* reference residue against a gap: k + 1 on this row */
+				if (k < cols - 1)
+				{
+					size_t left = here + 1;
+					int open = match[left] - GAP_OPEN;
+					int extend = del[left] - GAP_EXTEND;
+					
+					if (open >= extend && match[left] > UNREACHABLE)
+					{
+						del[here] = open;
+					}
+					else if (del[left] > UNREACHABLE)
+					{
+						del[here] = extend;
+						tr |= 1 << 3;
+					}
+				}
+			}
+
+			trace[here] = tr;
+
+			/* overhangs at the end are free too */
+			if (i == n || j == m)
+			{
+				int mine = std::max(match[here], 
+				                    std::max(insert[here], del[here]));
+
+				if (mine > best)
+				{
+					best = mine;
+					bestI = i;
+					bestK = k;
+				}
+			}
+		}
+	}
+	
+	if (bestI < 0)
+	{
+		return false;
+	}
+
+	_left.clear();
+	_align.clear();
+	_right.clear();
+	_indices.clear();
+
+	int i = bestI;
+	int k = bestK;
+	int j = i - low - k;
+	size_t here = (size_t)i * cols + k;
+	int state = FromMatch;
+
+	if (insert[here] == best)
+	{
+		state = FromInsert;
+	}
+	else if (del[here] == best)
+	{
+		state = FromDelete;
+	}
+
+	/* built backwards, then reversed */
+	for (int l = m - 1; l >= j; l--)
+	{
+		addColumn('-', '-', _ref[l], l);
+	}
+
+	for (int l = n - 1; l >= i; l--)
+	{
+		addColumn(_seq[l], '+', '-', m - 1);
+	}
+
+	bool touched = false;
+
+	while (i > 0 && j > 0)
+	{
+		here = (size_t)i * cols + k;
+		unsigned char tr = trace[here];
+		
+		if (k == 0 || k == cols - 1)
+		{
+			touched = true;
+		}
+
+		if (state == FromMatch)
+		{
+			char a = (_seq[i - 1] == _ref[j - 1] ? '.' : '*');
+			addColumn(_seq[i - 1], a, _ref[j - 1], j - 1);
+			state = tr & 3;
+			i--; j--;
+		}
+		else if (state == FromInsert)
+		{
+			addColumn(_seq[i - 1], '+', '-', j);
+			state = (tr & (1 << 2)) ? FromInsert : FromMatch;
+			i--; k--;
+		}
+		else
+		{
+			addColumn('-', '-', _ref[j - 1], j - 1);
+			state = (tr & (1 << 3)) ? FromDelete : FromMatch;
+			j--; k++;
+		}
+		
+		if (state == FromStart)
+		{
+			break;
+		}
+	}
+	
+	for (int l = j - 1; l >= 0; l--)
+	{
+		addColumn('-', '-', _ref[l], l);
+	}
+
+	for (int l = i - 1; l >= 0; l--)
+	{
+		addColumn(_seq[l], '+', '-', 0);
+	}
+	
+	/* the best path may lie outside a band this narrow */
+	if (touched)
+	{
+		return false;
+	}
+
+	std::reverse(_left.begin(), _left.end());
+	std::reverse(_align.begin(), _align.end());
+	std::reverse(_right.begin(), _right.end());
+	std::reverse(_indices.begin(), _indices.end());
+
+	return true;
+}
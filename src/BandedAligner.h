@@ -0,0 +1,83 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__bandedaligner__
+#define __breathalyser__bandedaligner__
+
+#include <string>
+#include <vector>
+
+/* affine-gap alignment of a sequence against a reference, only filling in
+ * cells within a band around an expected diagonal (sequence index minus
+ * reference index). The band is doubled until the best path no longer
+ * touches its edges. Output mirrors print_alignments: left is the
+ * sequence, right the reference, and align has '.' for matches, '*' for
+ * substitutions, '+' for insertions and '-' for deletions; indices give
+ * the reference position of each column. */
+
+class BandedAligner
+{
+public:
+	BandedAligner(const std::string &seq, const std::string &ref, 
+	              int diagonal);
+
+	/* false if the band had to grow past maxWidth; caller should fall
+	 * back to a full alignment */
+	bool run(int width = 8, int maxWidth = 256);
+	
+	const std::string &left()
+	{
+		return _left;
+	}
+	
+	const std::string &align()
+	{
+		return _align;
+	}
+	
+	const std::string &right()
+	{
+		return _right;
+	}
+	
+	const std::vector<int> &indices()
+	{
+		return _indices;
+	}
+	
+	int width()
+	{
+		return _width;
+	}
+private:
+	bool alignWithin(int width);
+	void addColumn(char l, char a, char r, int index);
+	int score(char a, char b);
+
+	std::string _seq;
+	std::string _ref;
+	int _diagonal;
+	int _width;
+
+	std::string _left;
+	std::string _align;
+	std::string _right;
+	std::vector<int> _indices;
+};
+
+#endif
@@ -0,0 +1,240 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "CoOccurrence.h"
+#include "MutationIndex.h"
+#include "Ensemble.h"
+#include "Workers.h"
+#include "Fasta.h"
+#include <hcsrc/FileReader.h>
+#include <iostream>
+#include <fstream>
+#include <cstdint>
+#include <algorithm>
+
+CoOccurrence::CoOccurrence(MutationIndex *index, int start, int end)
+{
+	_index = index;
+	_total = 1;
+	_size = 0;
+
+	/* residues are numbered along the reference, which comes first */
+	int length = 0;
+	if (_index->size() > 0)
+	{
+		length = _index->fasta(0)->result().length();
+	}
+	
+	_start = std::max(start, 0);
+	_end = std::min(end, length);
+
+	/* nothing is allocated for a range the user got wrong */
+	if (_start >= _end)
+	{
+		std::cout << "Co-occurrence range " << start << "-" << end 
+		<< " is empty within the reference (0-" << length << ")" 
+		<< std::endl;
+		return;
+	}
+
+	_size = _end - _start + 1;
+}
+
+void CoOccurrence::calculate()
+{
+	if (_size == 0)
+	{
+		return;
+	}
+
+	/* same sequences as a requirement group would take */
+	std::vector<char> eligible(_index->size(), 0);
+	for (size_t i = 1; i < _index->size(); i++)
+	{
+		eligible[i] = Ensemble::canProcess(_index->fasta(i));
+	}
+
+	_lists.clear();
+	_lists.resize(_size);
+	double count = 0;
+	_total = 1;
+
+	for (int i = 0; i < _size; i++)
+	{
+		const std::vector<int> &all = _index->withResidue(i + _start);
+		
+		for (size_t k = 0; k < all.size(); k++)
+		{
+			if (eligible[all[k]])
+			{
+				_lists[i].push_back(all[k]);
+			}
+		}
+		
+		if (_lists[i].size())
+		{
+			_total += _lists[i].size();
+			count++;
+		}
+	}
+
+	_total /= count * 10;
+	_counts.clear();
+	_counts.resize(_size * _size, 0);
+	
+	std::cout << "Co-occurrence between residues " << _start << " and "
+	<< _end << std::endl;
+
+	parallel_for(_size, [&](size_t i, size_t)
+	{
+		const std::vector<int> &mine = _lists[i];
+		_counts[i * _size + i] = mine.size();
+
+		for (int j = i + 1; j < _size && mine.size(); j++)
+		{
+			const std::vector<int> &theirs = _lists[j];
+			size_t a = 0; size_t b = 0;
+			int both = 0;
+
+			while (a < mine.size() && b < theirs.size())
+			{
+				if (mine[a] < theirs[b])
+				{
+					a++;
+				}
+				else if (mine[a] > theirs[b])
+				{
+					b++;
+				}
+				else
+				{
+					both++; a++; b++;
+				}
+			}
+			
+			/* row j belongs to another worker, so mirror afterwards */
+			_counts[i * _size + j] = both;
+		}
+	}, true);
+
+	for (int i = 0; i < _size; i++)
+	{
+		for (int j = i + 1; j < _size; j++)
+		{
+			_counts[j * _size + i] = _counts[i * _size + j];
+		}
+	}
+}
+
+bool CoOccurrence::write(std::string filename)
+{
+	if (_size == 0)
+	{
+		return false;
+	}
+
+	if (getExtension(filename) == "bin")
+	{
+		return writeBinary(filename);
+	}
+	
+	return writeCSV(filename);
+}
+
+bool CoOccurrence::writeCSV(std::string filename)
+{
+	std::ofstream file;
+	file.open(filename);
+	
+	if (!file.is_open())
+	{
+		std::cout << "Could not write to " << filename << std::endl;
+		return false;
+	}
+
+	for (int i = _start; i < _end; i++)
+	{
+		for (int j = i + 1; j <= _end; j++)
+		{
+			int both = count(i, j);
+
+			if (both == 0)
+			{
+				continue;
+			}
+
+			std::string zi, zj;
+			std::string in = i_to_str(i);
+			std::string jn = i_to_str(j);
+
+			if (i <= 999)
+			{
+				zi = std::string(3 - in.length(), '0');
+			}
+
+			if (j <= 999)
+			{
+				zj = std::string(3 - jn.length(), '0');
+			}
+
+			/* counts the reference, as requirement groups used to */
+			file << zi << in << "," << zj << jn << "," 
+			<< (both + 1) / _total << std::endl;
+		}
+	}
+	
+	file.close();
+	std::cout << "Written co-occurrence to " << filename << std::endl;
+
+	return true;
+}
+
+bool CoOccurrence::writeBinary(std::string filename)
+{
+	std::ofstream file;
+	file.open(filename, std::ios::binary);
+	
+	if (!file.is_open())
+	{
+		std::cout << "Could not write to " << filename << std::endl;
+		return false;
+	}
+	
+	int32_t start = _start;
+	int32_t end = _end;
+	file.write((const char *)&start, sizeof(int32_t));
+	file.write((const char *)&end, sizeof(int32_t));
+	file.write((const char *)&_total, sizeof(double));
+	
+	std::vector<int32_t> row(_size);
+
+	for (int i = 0; i < _size; i++)
+	{
+		for (int j = 0; j < _size; j++)
+		{
+			row[j] = _counts[i * _size + j];
+		}
+
+		file.write((const char *)&row[0], sizeof(int32_t) * _size);
+	}
+	
+	file.close();
+	std::cout << "Written co-occurrence to " << filename << std::endl;
+
+	return true;
+}
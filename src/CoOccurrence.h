@@ -0,0 +1,62 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__cooccurrence__
+#define __breathalyser__cooccurrence__
+
+#include <string>
+#include <vector>
+
+class MutationIndex;
+
+/* counts how many sequences carry changes at both of each pair of
+ * residues within a range, straight from a mutation index */
+
+class CoOccurrence
+{
+public:
+	/* the range is clamped to the reference; if nothing is left, nothing
+	 * is calculated or written */
+	CoOccurrence(MutationIndex *index, int start, int end);
+
+	void calculate();
+
+	/* ".bin" gives start, end (int32), total (double) and then the whole
+	 * (end - start + 1)^2 matrix of counts (int32), row by row; anything
+	 * else gives "i,j,score" lines for each co-occurring pair */
+	bool write(std::string filename);
+
+	int count(int i, int j)
+	{
+		return _counts[(i - _start) * _size + (j - _start)];
+	}
+private:
+	bool writeCSV(std::string filename);
+	bool writeBinary(std::string filename);
+
+	MutationIndex *_index;
+	int _start;
+	int _end;
+	int _size;
+	double _total;
+
+	std::vector<std::vector<int> > _lists;
+	std::vector<int> _counts;
+};
+
+#endif
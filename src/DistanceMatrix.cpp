@@ -0,0 +1,138 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "DistanceMatrix.h"
+#include "Fasta.h"
+#include "Workers.h"
+#include <cmath>
+#include <climits>
+#include <algorithm>
+
+#define TILE_SIZE 128
+
+DistanceMatrix::DistanceMatrix(const std::vector<Fasta *> &fastas)
+{
+	_ids.resize(fastas.size());
+
+	for (size_t i = 0; i < fastas.size(); i++)
+	{
+		_ids[i] = fastas[i]->mutationIds();
+	}
+}
+
+DistanceMatrix::DistanceMatrix(const std::vector<std::vector<int> > &ids)
+{
+	_ids = ids;
+}
+
+/* merge of two sorted id lists, as Fasta::sharedMutations */
+int DistanceMatrix::difference(const std::vector<int> &a, 
+                               const std::vector<int> &b)
+{
+	size_t i = 0; size_t j = 0;
+	int common = 0;
+
+	while (i < a.size() && j < b.size())
+	{
+		if (a[i] < b[j])
+		{
+			i++;
+		}
+		else if (a[i] > b[j])
+		{
+			j++;
+		}
+		else
+		{
+			common++; i++; j++;
+		}
+	}
+
+	return a.size() + b.size() - 2 * common;
+}
+
+void DistanceMatrix::calculate()
+{
+	size_t n = size();
+	_distances.clear();
+	
+	size_t longest = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		longest = std::max(longest, _ids[i].size());
+	}
+	
+	int most = std::min(2 * longest, (size_t)USHRT_MAX);
+
+	/* so that only as many exponentials as distances are needed */
+	_scores.resize(most + 1);
+	for (int d = 0; d <= most; d++)
+	{
+		double muts = d / 4.;
+		_scores[d] = exp(-(muts * muts));
+	}
+
+	if (n < 2)
+	{
+		return;
+	}
+
+	_distances.resize(n * (n - 1) / 2);
+
+	std::vector<std::pair<size_t, size_t> > tiles;
+	for (size_t i = 0; i < n; i += TILE_SIZE)
+	{
+		for (size_t j = i; j < n; j += TILE_SIZE)
+		{
+			tiles.push_back(std::make_pair(i, j));
+		}
+	}
+
+	/* each tile writes to its own cells of the triangle */
+	parallel_for(tiles.size(), [&](size_t t, size_t)
+	{
+		size_t si = tiles[t].first;
+		size_t sj = tiles[t].second;
+		size_t ei = std::min(si + TILE_SIZE, n);
+		size_t ej = std::min(sj + TILE_SIZE, n);
+
+		for (size_t i = si; i < ei; i++)
+		{
+			for (size_t j = std::max(sj, i + 1); j < ej; j++)
+			{
+				int d = difference(_ids[i], _ids[j]);
+				_distances[offset(i, j)] = std::min(d, most);
+			}
+		}
+	}, true);
+}
+
+int DistanceMatrix::distance(size_t i, size_t j) const
+{
+	if (i == j)
+	{
+		return 0;
+	}
+
+	if (i > j)
+	{
+		std::swap(i, j);
+	}
+
+	return _distances[offset(i, j)];
+}
@@ -0,0 +1,67 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__distancematrix__
+#define __breathalyser__distancematrix__
+
+#include <cstddef>
+#include <vector>
+
+class Fasta;
+
+/* number of mutations by which each pair of sequences differ, with the
+ * similarity exp(-(d/4)^2) used for clustering. Pairs are worked through 
+ * in square tiles across all the cores. Only one triangle is kept. */
+
+class DistanceMatrix
+{
+public:
+	DistanceMatrix(const std::vector<Fasta *> &fastas);
+	
+	/* from sorted mutation id lists, e.g. of haplotypes */
+	DistanceMatrix(const std::vector<std::vector<int> > &ids);
+
+	void calculate();
+
+	size_t size() const
+	{
+		return _ids.size();
+	}
+
+	int distance(size_t i, size_t j) const;
+
+	double similarity(size_t i, size_t j) const
+	{
+		return _scores[distance(i, j)];
+	}
+private:
+	size_t offset(size_t i, size_t j) const
+	{
+		/* row i of the upper triangle, skipping the diagonal */
+		return i * (2 * size() - i - 1) / 2 + (j - i - 1);
+	}
+
+	static int difference(const std::vector<int> &a, 
+	                      const std::vector<int> &b);
+
+	std::vector<std::vector<int> > _ids;
+	std::vector<unsigned short> _distances;
+	std::vector<double> _scores;
+};
+
+#endif
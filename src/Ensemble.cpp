@@ -19,12 +19,14 @@
 #include "Ensemble.h"
 #include "Segment.h"
 #include "Fasta.h"
-
+#include "Requirements.h"
+#include "Workers.h"
+#include "HaplotypeTable.h"
+#include "BallBatch.h"
+#include "LabelBatch.h"
 
 #include <h3dsrc/shaders/vStructure.h>
 #include <h3dsrc/shaders/fStructure.h>
-#include <h3dsrc/Icosahedron.h>
-#include <h3dsrc/Text.h>
 #include <iostream>
 #include <algorithm>
 #include <libsrc/Polymer.h>
@@ -39,10 +41,14 @@ SlipObject()
 	_crystal = c;
 
 	_mode = -1;
-	_selected = NULL;
+	_selected = -1;
+	_ballBatch = new BallBatch();
+	_labelBatch = new LabelBatch(0.04, make_vec3(0, 4, 20));
 	_renderType = GL_LINES;
 	_isReference = false;
 	_fastaCount = 0;
+	_order = 0;
+	_clearCount = 0;
 	_vString = Structure_vsh();
 	_fString = Structure_fsh();
 	findChains();
@@ -535,18 +541,12 @@ void Ensemble::render(SlipGL *gl)
 	
 	if (_mode < 0 || _mode == 0)
 	{
-		for (size_t i = 0; i < _balls.size(); i++)
-		{
-			_balls[i]->render(gl);
-		}
+		_ballBatch->render(gl);
 	}
 	
 	if (_mode < 0 || _mode == 1)
 	{
-		for (size_t i = 0; i < _texts.size(); i++)
-		{
-			_texts[i]->render(gl);
-		}
+		_labelBatch->render(gl);
 	}
 
 	SlipObject::render(gl);
@@ -619,212 +619,295 @@ void Ensemble::deleteSegments()
 	_segments.clear();
 }
 
-void Ensemble::processNucleotides(Fasta *f)
+void Ensemble::processNucleotides(Fasta *f, KmerIndex *index)
+{
+	std::vector<Fasta *> fastas(1, f);
+	processNucleotides(fastas, index);
+}
+
+void Ensemble::processNucleotides(std::vector<Fasta *> &fastas, 
+                                  KmerIndex *index)
 {
 	int minRes = 0; int maxRes = 0;
 	minMaxResidues(chain(0), &minRes, &maxRes);
-	f->setOffset(minRes);
 
-	if (f->hasResult())
+	parallel_for(fastas.size(), [&](size_t i, size_t t)
 	{
-		return;
-	}
+		Fasta *f = fastas[i];
+		f->setOffset(minRes);
 
-	std::string seq = generateSequence(chain(0));
-	f->roughCompare(seq, minRes);
+		if (!f->hasResult())
+		{
+			f->roughCompare(index, minRes);
+		}
+	});
 }
 
-bool Ensemble::shouldProcess(Fasta *f, std::string requirements)
+bool Ensemble::canProcess(Fasta *f)
 {
-	bool should = true;
+	return !(f->isProblematic() || !f->hasResult() || f->isReference());
+}
 
-	if (f->isProblematic() || !f->hasResult() || f->isReference())
+bool Ensemble::shouldProcess(Fasta *f, const Requirements &requirements)
+{
+	if (!canProcess(f))
 	{
 		return false;
 	}
 	
-	if (f->result().find(' ') != std::string::npos)
+	return requirements.matches(f);
+}
+
+bool Ensemble::processFasta(Fasta *f, const Requirements &requirements)
+{
+	std::vector<Fasta *> fastas(1, f);
+	return (processFastas(fastas, requirements) > 0);
+}
+
+size_t Ensemble::processFastas(std::vector<Fasta *> &fastas,
+                               const Requirements &requirements)
+{
+	std::vector<Fasta *> todo;
+	std::set<Fasta *> seen;
+
+	for (size_t i = 0; i < fastas.size(); i++)
 	{
-//		return false;
+		if (_shown.count(fastas[i]) || seen.count(fastas[i]))
+		{
+			continue;
+		}
+		
+		seen.insert(fastas[i]);
+		todo.push_back(fastas[i]);
 	}
-	
-	if (requirements.length() > 0)
+
+	MutationHistogram hist;
+	std::vector<Fasta *> passed;
+	countFastas(todo, requirements, &hist, &passed);
+	addCounts(hist, passed, todo.size());
+
+	return passed.size();
+}
+
+bool Ensemble::countFastas(std::vector<Fasta *> &fastas,
+                           const Requirements &requirements,
+                           MutationHistogram *hist, 
+                           std::vector<Fasta *> *passed,
+                           CancelCheck cancelled)
+{
+	std::vector<char> ok(fastas.size(), 0);
+	bool count = (_crystal && _crystal->atomCount() > 0);
+
+	/* requirements and counts only depend on the mutations, so they are
+	 * worked out once per haplotype and weighted by its usable members */
+	HaplotypeTable haps;
+	haps.update(fastas);
+
+	/* each worker fills its own histogram, merged once they're done */
+	std::vector<MutationHistogram> hists(worker_count());
+	parallel_for(haps.haplotypeCount(), [&](size_t h, size_t t)
 	{
-		std::vector<std::string> reqs = split(requirements, ',');
-		
-		for (size_t j = 0; j < reqs.size(); j++)
+		const std::vector<int> &members = haps.members(h);
+		int first = -1;
+		int weight = 0;
+
+		for (size_t k = 0; k < members.size(); k++)
 		{
-			bool found = false;
-			bool invert = false;
-			std::string req = reqs[j];
-			
-			if (req[0] == '!')
-			{
-				req.erase(req.begin());
-				invert = true;
-			}
-			
-			if (req[0] < '0' || req[0] > '9')
-			{
-				req.erase(req.begin());
-			}
-			
-			for (size_t i = 0; i < f->mutationCount(); i++)
+			if (canProcess(fastas[members[k]]))
 			{
-				std::string variant = f->mutation(i);
-				std::string ending = variant.substr(1);
-				
-				int comp_length = std::min(ending.length(), req.length());
-
-				if (req.substr(0, comp_length) == 
-				    ending.substr(0, comp_length))
-				{
-					if (ending.length() > req.length())
-					{
-						char tmp = ending[req.length()];
-						
-						if (tmp > '0' && tmp <= '9')
-						{
-							/* numerical, stops 47 matching 470 */
-							break;
-						}
-					}
-
-					found = true;
-					break;
-				}
+				first = (first < 0 ? members[k] : first);
+				weight++;
 			}
+		}
+		
+		if (cancelled() || first < 0 || !requirements.matches(fastas[first]))
+		{
+			return;
+		}
 
-			if ((!found && !invert) || (found && invert))
-			{
-				should = false;
-			}
+		for (size_t k = 0; k < members.size(); k++)
+		{
+			ok[members[k]] = canProcess(fastas[members[k]]);
+		}
+		
+		if (!count)
+		{
+			return;
 		}
+
+		/* ordered by first sequence, then by position within it */
+		Fasta *f = fastas[first];
+		for (size_t j = 0; j < f->mutationCount(); j++)
+		{
+			hists[t].add(f->mutation(j), ((unsigned long)first << 16) + j, 
+			             weight);
+		}
+	});
+	
+	if (cancelled())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < hists.size(); i++)
+	{
+		hist->merge(hists[i]);
 	}
 	
-	return should;
+	for (size_t i = 0; i < fastas.size(); i++)
+	{
+		if (ok[i])
+		{
+			passed->push_back(fastas[i]);
+		}
+	}
+
+	return true;
 }
 
-bool Ensemble::processFasta(Fasta *f, std::string requirements)
+void Ensemble::addCounts(const MutationHistogram &hist, 
+                         const std::vector<Fasta *> &passed, size_t considered)
 {
-	bool should = shouldProcess(f, requirements);
-	
-	if (!should)
+	_muts.merge(hist, _order << 16);
+
+	for (size_t i = 0; i < passed.size(); i++)
+	{
+		_shown.insert(passed[i]);
+	}
+
+	_order += considered;
+	_fastaCount += passed.size();
+}
+
+bool Ensemble::unprocessFasta(Fasta *f)
+{
+	if (_shown.count(f) == 0)
 	{
 		return false;
 	}
 	
 	for (size_t i = 0; i < f->mutationCount(); i++)
 	{
-		processMutation(f->mutation(i));
+		_muts.remove(f->mutation(i));
 	}
-	
-	_fastaCount++;
+
+	_shown.erase(f);
+	_fastaCount--;
 
 	return true;
 }
 
-void Ensemble::processMutation(std::string mutation)
+void Ensemble::removeBall(size_t i)
 {
-	int mut = atoi(&mutation.c_str()[1]);
-	
-	if (_crystal->atomCount() == 0)
+	if (_selected == (int)i)
 	{
-		return;
+		_selected = -1;
 	}
+
+	_ballBatch->removeBall(i);
+	setLabel(i, "");
 	
-	_muts[mut].push_back(mutation);
+	_drawn[i].aas = "";
+	_drawn[i].pct = 0;
 }
 
-size_t Ensemble::makeBalls()
+void Ensemble::setLabel(size_t i, std::string str)
 {
-	if (_fastaCount < 1)
+	if (str.length() == 0)
 	{
-		return 0;
+		_labelBatch->removeLabel(i);
+		return;
 	}
 
+	vec3 abs = _cas[i]->getAbsolutePosition();
+	_labelBatch->setLabel(i, abs, str);
+}
+
+/* only remakes the balls whose appearance has changed since last time */
+size_t Ensemble::makeBalls()
+{
 	if (_cas.size() == 0 && _crystal)
 	{
 		_cas = _crystal->findAtoms("CA");
 	}
-
+	
+	if (_drawn.size() != _cas.size())
+	{
+		_ballBatch->setSlotCount(_cas.size());
+		_labelBatch->setSlotCount(_cas.size());
+		BallState empty;
+		empty.pct = 0;
+		_drawn.resize(_cas.size(), empty);
+	}
 
 	for (size_t i = 0; i < _cas.size(); i++)
 	{
 		int resNum = _cas[i]->getResidueNum();
+		double counts = _muts.total(resNum);
 		
-		if (_muts[resNum].size() == 0)
+		if (_fastaCount < 1 || counts == 0)
 		{
+			removeBall(i);
 			continue;
 		}
 		
-		std::string aas;
-		unsigned char refaa = _muts[resNum][0][0];
-		for (size_t j = 0; j < _muts[resNum].size(); j++)
-		{
-			unsigned char back = _muts[resNum][j].back();
-			
-			if (aas.find(back) == std::string::npos)
-			{
-				aas.push_back(back);
-			}
-		}
-
-		double counts = _muts[resNum].size();
+		std::string aas = _muts.alts(resNum);
+		unsigned char refaa = _muts.reference(resNum);
 
 		double pct = 100 * counts / (double)_fastaCount;
 		double pct100 = 100 * pct;
 		
+		if (_drawn[i].pct == pct && _drawn[i].aas == aas && 
+		    _drawn[i].refaa == refaa)
+		{
+			continue;
+		}
+		
 		double inflate = log(pct100) / log(100);
 		
 		/* no negatives! */
 		if (inflate < 0)
 		{
+			removeBall(i);
 			continue;
 		}
 
 		vec3 abs = _cas[i]->getAbsolutePosition();
+		std::string str;
 
 		if (pct > 0.3)
 		{
-			std::string str;
 			str += refaa;
 			str += i_to_str(resNum) + aas + ", ";
 			str += f_to_str(pct, 1) + "%";
-			Text *text = new Text();
-			text->setProperties(abs, str, 120, Qt::black,
-			                    0, 4, 20);
-			text->prepare();
-			_texts.push_back(text);
-			_textMap[_cas[i]] = text;
 		}
+		
+		setLabel(i, str);
 
-		Icosahedron *ico = new Icosahedron();
-		ico->setPosition(abs);
-		ico->setColour(1.0, 0.3, 0.3);
+		vec3 colour = make_vec3(1.0, 0.3, 0.3);
 		
 		if (aas[0] == '-')
 		{
-			ico->setColour(0.2, 0.2, 0.2);
+			colour = make_vec3(0.2, 0.2, 0.2);
 		}
 		else if (aas[0] == '+')
 		{
-			ico->setColour(0.3, 0.3, 1.0);
+			colour = make_vec3(0.3, 0.3, 1.0);
 		}
 		else if (aas[0] == '>' || aas[0] == '<')
 		{
-			ico->setColour(1, 1.0, 0.3);
+			colour = make_vec3(1, 1.0, 0.3);
 		}
 
-		ico->triangulate();
-		std::string v = Structure_vsh();
-		std::string f = Structure_fsh();
-		ico->changeProgram(v, f);
-		ico->resize(inflate);
-		ico->setSelectable(true);
-
-		_balls.push_back(ico);
-		_ballMap[ico] = i_to_str(resNum);
+		_ballBatch->setBall(i, abs, inflate, colour);
+		_drawn[i].pct = pct;
+		_drawn[i].aas = aas;
+		_drawn[i].refaa = refaa;
+	}
+	
+	if (_fastaCount < 1)
+	{
+		return 0;
 	}
 	
 	return _fastaCount;
@@ -832,63 +915,33 @@ size_t Ensemble::makeBalls()
 
 void Ensemble::clearBalls()
 {
-	for (size_t i = 0; i < _balls.size(); i++)
-	{
-		delete _balls[i];
-	}
-
-	for (size_t i = 0; i < _texts.size(); i++)
-	{
-		delete _texts[i];
-	}
-
-	_selected = NULL;
-	_texts.clear();
-	_balls.clear();
-	std::vector<Text *>().swap(_texts);
-	std::vector<Icosahedron *>().swap(_balls);
-	_ballMap.clear();
-	_textMap.clear();
+	_selected = -1;
+	_ballBatch->clearBalls();
+	_labelBatch->clearLabels();
+	_drawn.clear();
 	_muts.clear();
+	_shown.clear();
 	_fastaCount = 0;
+	_order = 0;
+	_clearCount++;
 }
 
 std::string Ensemble::whichMutation(double x, double y)
 {
-	Icosahedron *which = NULL;
-	double z = -FLT_MAX;
-
-	for (size_t i = 0; i < _balls.size(); i++)
-	{
-		bool covers = _balls[i]->intersects(x, y, &z);
-		_balls[i]->setSelected(false);
-		
-		if (covers)
-		{
-			which = _balls[i];
-		}
-	}
-	
-	_selected = which;
-	
-	if (which == NULL)
-	{
-		return "";
-	}
-
-	which->setSelected(true);
+	_selected = _ballBatch->ballAt(x, y);
+	_ballBatch->setSelectedBall(_selected);
 
-	return _ballMap[which];
+	return selectedMutation();
 }
 
 std::string Ensemble::selectedMutation()
 {
-	if (_selected == NULL)
+	if (_selected < 0)
 	{
 		return "";
 	}
 
-	return _ballMap[_selected];
+	return i_to_str(_cas[_selected]->getResidueNum());
 }
 
 void Ensemble::clearMutations()
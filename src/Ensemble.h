@@ -20,12 +20,18 @@
 #define __breathalyser__ensemble__ 
 
 #include <QTreeWidgetItem>
+#include <set>
 #include <h3dsrc/SlipObject.h>
+#include "Mutation.h"
+#include "Requirements.h"
+#include "MutationHistogram.h"
+#include "Workers.h"
 
-class Text;
 class Fasta;
 class Segment;
-class Icosahedron;
+class KmerIndex;
+class BallBatch;
+class LabelBatch;
 
 class Atom;
 typedef boost::shared_ptr<Atom> AtomPtr;
@@ -112,7 +118,9 @@ public:
 	
 	void deleteSegments();
 
-	void processNucleotides(Fasta *f);
+	/* index is of this ensemble's first chain sequence */
+	void processNucleotides(Fasta *f, KmerIndex *index);
+	void processNucleotides(std::vector<Fasta *> &fastas, KmerIndex *index);
 	void addCAlpha(vec3 point);
 	void repopulate();
 	void updateText();
@@ -121,10 +129,38 @@ public:
 	virtual void render(SlipGL *gl);
 
 	size_t makeBalls();
-	bool processFasta(Fasta *f, std::string requirements = "");
-	bool shouldProcess(Fasta *f, std::string requirements = "");
+	bool processFasta(Fasta *f, 
+	                  const Requirements &requirements = Requirements());
+
+	/* as processFasta for many, counting mutations on worker threads */
+	size_t processFastas(std::vector<Fasta *> &fastas,
+	                     const Requirements &requirements = Requirements());
+
+	/* counts mutations of those which should be processed into hist, 
+	 * once per haplotype, without touching what is shown, so may be 
+	 * called off the GUI thread. Returns false if cancelled part way. */
+	bool countFastas(std::vector<Fasta *> &fastas,
+	                 const Requirements &requirements,
+	                 MutationHistogram *hist, std::vector<Fasta *> *passed,
+	                 CancelCheck cancelled = never_cancelled);
+
+	/* shows the results of countFastas */
+	void addCounts(const MutationHistogram &hist, 
+	               const std::vector<Fasta *> &passed, size_t considered);
+	
+	/* takes back a processed Fasta, e.g. as it leaves a sliding window */
+	bool unprocessFasta(Fasta *f);
+	bool shouldProcess(Fasta *f, 
+	                   const Requirements &requirements = Requirements());
+	static bool canProcess(Fasta *f);
 	void clearBalls();
 	void clearMutations();
+	
+	/* goes up every time the balls are cleared */
+	unsigned long clearCount()
+	{
+		return _clearCount;
+	}
 
 	void minMaxResidues(std::string ch, int *min, int *max);
 	std::string generateSequence(std::string chain, int *minRes = NULL);
@@ -140,17 +176,30 @@ private:
 	void convertToCylinder();
 	void addCircle(vec3 centre, std::vector<vec3> &circle);
 	void addCylinderIndices(size_t num);
-	void processMutation(std::string mutation);
+	void removeBall(size_t i);
+	void setLabel(size_t i, std::string str);
+
+	typedef struct
+	{
+		double pct;
+		std::string aas;
+		unsigned char refaa;
+	} BallState;
+
 	std::vector<Segment *> _segments;
-	std::vector<Icosahedron *> _balls;
-	std::vector<Text *> _texts;
-	std::map<Icosahedron *, std::string> _ballMap;
-	std::map<AtomPtr, Text *> _textMap;
-	std::map<int, std::vector<std::string> > _muts;
+	MutationHistogram _muts;
+	std::set<Fasta *> _shown;
+	unsigned long _order;
+
+	/* per entry of _cas, what is currently drawn there */
+	std::vector<BallState> _drawn;
 	
-	Icosahedron *_selected;
+	BallBatch *_ballBatch;
+	LabelBatch *_labelBatch;
+	int _selected;
 
 	int _fastaCount;
+	unsigned long _clearCount;
 	void findChains();
 	void convertToBezier();
 	CrystalPtr _crystal;
@@ -19,6 +19,11 @@
 #include "Fasta.h"
 #include "FastaGroup.h"
 #include "FastaMaster.h"
+#include "Translation.h"
+#include "OrfScanner.h"
+#include "KmerIndex.h"
+#include "BandedAligner.h"
+#include "AlignmentCache.h"
 
 #include <algorithm>
 #include <iostream>
@@ -30,40 +35,13 @@
 #include <hcsrc/FileReader.h>
 
 bool Fasta::_justify = true;
+bool Fasta::_banded = true;
+std::atomic<unsigned long> Fasta::_generation(0);
 
-inline bool isAddition(std::string m)
+void Fasta::decrementResidue(Mutation &m, int go_back)
 {
-	return (m.back() == '+');
-}
-
-inline bool isDeletion(std::string m)
-{
-	return (m.back() == '-');
-}
-
-inline int residue(std::string m)
-{
-	int mut = atoi(&m.c_str()[1]);
-	return mut;
-}
-
-inline bool isResidue(std::string m, int i)
-{
-	int mut = atoi(&m.c_str()[1]);
-	return mut == i;
-}
-
-void Fasta::decrementResidue(std::string &m, int go_back)
-{
-//	unsigned char orig = m[0];
-	int mut = atoi(&m.c_str()[1]);
-	unsigned char last = m.back();
-	std::string new_mut;
-	unsigned char replacement = _ref[mut - go_back];
-	new_mut += replacement;
-	new_mut += i_to_str(mut - go_back);
-	new_mut += last;
-	m = new_mut;
+	m.resi -= go_back;
+	m.ref = _ref[m.resi];
 }
 
 Fasta::Fasta(std::string name)
@@ -75,6 +53,8 @@ Fasta::Fasta(std::string name)
 	_orf = -1;
 	_stop = -1;
 	_offset = -1;
+	_diagonal = 0;
+	_metadataRow = -1;
 	setText(0, QString::fromStdString(name));
 }
 
@@ -99,253 +79,67 @@ void Fasta::description()
 	std::cout << "Sequence of " << _seq.size() << " nucleotides." << std::endl;
 }
 
-bool Fasta::findNextORF()
+std::string Fasta::generateSequence()
 {
-	bool success = true;
-	if (true || _orf < 0)
-	{
-		success = findNextATG();
-	}
-	
-	if (!success)
-	{
-		return false;
-	}
-
-	success = findNextStopCodon();
-	
-	if (!success)
-	{
-//		return findNextATG();
-	}
-	
-	return success;
+	return translate_sequence(_seq, _orf, _stop + 3);
 }
 
-bool Fasta::findNextATG()
+bool Fasta::roughlyAlign(std::string mine, const KmerIndex *ref, int minRes)
 {
-	_orf++;
-	bool success = false;
-
-	while (_orf < (int)_seq.length() - 3)
+	if (mine == "" && hasResult())
 	{
-		if (_seq.substr(_orf, 3) == "ATG")
-		{
-			_stop = _seq.length() - 1;
-			success = true;
-			break;
-		}
-		
-		_orf++;
+		mine = result();
 	}
-	
-	if (success)
+	else if (mine == "")
 	{
-//		std::cout << "ATG at index: "  << _orf << std::endl;
+		return false;
 	}
 	
-	return (success);
-}
-
-bool Fasta::findNextStopCodon()
-{
-	_stop--;
-	int remainder = ((_stop - _orf) % 3);
-	_stop -= remainder;
-	bool success = false;
+	/* position of earliest reference probe in my sequence */
+	int i = 0;
+	int loc = 0;
 
-	while (_stop > _orf + 3)
+	if (!ref->anchor(mine, &i, &loc))
 	{
-		std::string tmp = _seq.substr(_stop, 3);
-		if (tmp == "TAA" || tmp == "TAG" || tmp == "TGA")
-		{
-			success = true;
-			break;
-		}
-		
-		_stop -= 3;
+		return false;
 	}
-	
-	return success;
-}
 
-std::string aaLetter(std::string str)
-{
-	if (str == "TTT" || str == "TTC")
-	{
-		return "F";
-	}
-	else if (str == "TTA" || str == "TTG" || str == "CTT" ||
-	         str == "CTC" || str == "CTA" || str == "CTG")
-	{
-		return "L";
-	}
-	else if (str == "ATT" || str == "ATC" || str == "ATA")
-	{
-		return "I";
-	}
-	else if (str == "ATG")
-	{
-		return "M";
-	}
-	else if (str == "GTT" || str == "GTC" || str == "GTA"
-	         || str == "GTG")
-	{
-		return "V";
-	}
-	else if (str == "TCT" || str == "TCC" || str == "TCA"
-	         || str == "TCG" || str == "AGT" || str == "AGC")
-	{
-		return "S";
-	}
-	else if (str == "CCT" || str == "CCC" || str == "CCA"
-	         || str == "CCG")
-	{
-		return "P";
-	}
-	else if (str == "ACT" || str == "ACC" || str == "ACA"
-	         || str == "ACG")
-	{
-		return "T";
-	}
-	else if (str == "GCT" || str == "GCC" || str == "GCA"
-	         || str == "GCG")
-	{
-		return "A";
-	}
-	else if (str == "TAT" || str == "TAC")
-	{
-		return "Y";
-	}
-	else if (str == "CAT" || str == "CAC")
-	{
-		return "H";
-	}
-	else if (str == "CAA" || str == "CAG")
-	{
-		return "Q";
-	}
-	else if (str == "AAT" || str == "AAC")
-	{
-		return "N";
-	}
-	else if (str == "AAA" || str == "AAG")
-	{
-		return "K";
-	}
-	else if (str == "GAT" || str == "GAC")
-	{
-		return "D";
-	}
-	else if (str == "GAA" || str == "GAG")
-	{
-		return "E";
-	}
-	else if (str == "TGT" || str == "TGC")
-	{
-		return "C";
-	}
-	else if (str == "TGG")
-	{
-		return "W";
-	}
-	else if (str == "AGA" || str == "AGG" || str == "CGT"
-	         || str == "CGC" || str == "CGA" || str == "CGG")
-	{
-		return "R";
-	}
-	else if (str == "GGA" || str == "GGG" || str == "GGT"
-	         || str == "GGC")
-	{
-		return "G";
-	}
+	/* how much further forward we are in relation to ref */
+	int diff = loc - i;
 
-	return " ";
-}
+	/* which is also the beginning...*/
+	int beginning = diff;
 
-std::string Fasta::generateSequence()
-{
-	std::string aaSeq = "";
-	for (int i = _orf; i < _stop + 3; i += 3)
-	{
-		std::string tmp = _seq.substr(i, 3);
-		
-		std::string aa = aaLetter(tmp);
-		aaSeq += aa;
-	}
-	
-	return aaSeq;
-}
+	/* but we have minRes residues before then, which we may want */
+	beginning -= minRes;
 
-bool Fasta::roughlyAlign(std::string mine, std::string ref, int minRes)
-{
-	if (mine == "" && hasResult())
-	{
-		mine = result();
-	}
-	else if (mine == "")
+	/* but this might be too much */
+	if (beginning < 0)
 	{
-		return false;
+		minRes -= beginning;
+		beginning = 0;
 	}
-	
-	int size = 10;
 
-	for (size_t i = 0; i < ref.length(); i += size / 2)
-	{
-		std::string probe = ref.substr(i, size);
+	/* we do want the full length of the reference */
+	int end = ref->length();
 
-		if ((int)probe.length() < size)
-		{
-			break;
-		}
+	/* but this might be too much */
 
-		if (probe.find(" ") != std::string::npos)
-		{
-			continue;
-		}
+	if (end - beginning > (int)mine.length())
+	{
+		end = mine.length() - beginning;
+	}
 
-		/* position of probe in my sequence */
-		size_t loc = mine.find(probe);
+	_result = mine.substr(beginning, end);
+	_offset = minRes;
 
-		if (loc != std::string::npos)
-		{
-			/* how much further forward we are in relation to ref */
-			int diff = (int)loc - (int)i;
-			
-			/* which is also the beginning...*/
-			int beginning = diff;
-			
-			/* but we have minRes residues before then, which we may want */
-			beginning -= minRes;
-			
-			/* but this might be too much */
-			if (beginning < 0)
-			{
-				minRes -= beginning;
-				beginning = 0;
-			}
-			
-			/* we do want the full length of the reference */
-			int end = ref.length();
-			
-			/* but this might be too much */
-			
-			if (end - beginning > (int)mine.length())
-			{
-				end = mine.length() - beginning;
-			}
-
-			_result = mine.substr(beginning, end);
-			_offset = minRes;
-			_seq.clear();
-			return true;
-		}
-	}
-	
-	return false;
+	/* where the reference starts in relation to my result */
+	_diagonal = diff - beginning;
+	_seq.clear();
+	return true;
 }
 
-std::string Fasta::roughCompare(std::string ref, int minRes)
+std::string Fasta::roughCompare(const KmerIndex *ref, int minRes)
 {
 	if (hasResult())
 	{
@@ -357,15 +151,17 @@ std::string Fasta::roughCompare(std::string ref, int minRes)
 		return _result;
 	}
 
-	int count = 0;
-	while (findNextORF())
+	OrfScanner scanner(_seq);
+
+	for (size_t i = 0; i < scanner.orfCount(); i++)
 	{
-		count++;
-		std::string seq = generateSequence();
+		_orf = scanner.start(i);
+		_stop = scanner.stop(i);
+		std::string seq = scanner.protein(i);
 		
 		if (roughlyAlign(seq, ref, minRes))
 		{
-			std::cout << "After trying " << count << " ORFs, "
+			std::cout << "After trying " << i + 1 << " ORFs, "
 			" length " << seq.length() <<  " nt..." << std::endl;
 			return seq;
 		}
@@ -389,20 +185,18 @@ int Fasta::gapCount()
 
 void Fasta::addMutation(char fromWhat, int mut, char towhat)
 {
-	std::ostringstream ss;
-	ss << fromWhat << mut + _offset << towhat;
-	std::string str = ss.str();
-
-	_mutations.push_back(str);
+	_mutations.push_back(make_mutation(fromWhat, mut + _offset, towhat));
 }
 
 void Fasta::clearMutations()
 {
 	_mutations.clear();
+	_mutationIds.clear();
+	_generation++;
 	_compared = false;
 }
 
-void Fasta::carefulCompareWithFasta(Fasta *f)
+void Fasta::carefulCompareWithFasta(Fasta *f, bool record)
 {
 	if (!hasResult() && !f->hasResult())
 	{
@@ -423,27 +217,43 @@ void Fasta::carefulCompareWithFasta(Fasta *f)
 	organiseMap();
 	findGlycosylations();
 	removeDuplicateGlycosylations(f);
+	updateMutationIds();
+	
+	if (record)
+	{
+		recordMutations();
+	}
+}
+
+void Fasta::recordMutations()
+{
+	if (!hasCompared())
+	{
+		return;
+	}
 
 	for (size_t j = 0; j < mutationCount(); j++)
 	{
-		if (mutation(j).back() == '>' || mutation(j).back() == '<')
+		if (is_glycosylation(mutation(j)))
 		{
-			std::cout << name() << " " << mutation(j) << std::endl;
+			std::cout << name() << " " << mutationString(j) << std::endl;
 		}
 	}
+
+	FastaMaster::master()->addValue(this, "mutations", mutationSummary());
 }
 
 void Fasta::removeDuplicateGlycosylations(Fasta *f)
 {
 	for (size_t j = 0; j < f->mutationCount(); j++)
 	{
-		std::string refMut = f->mutation(j);
+		Mutation refMut = f->mutation(j);
 		bool found = false;
 		for (size_t i = 0; i < mutationCount(); i++)
 		{
-			std::string myMut = mutation(i);
+			const Mutation &myMut = mutation(i);
 			
-			if (myMut.back() == '<')
+			if (myMut.alt == '<')
 			{
 				continue;
 			}
@@ -456,9 +266,9 @@ void Fasta::removeDuplicateGlycosylations(Fasta *f)
 			}
 		}
 		
-		if (!found && refMut.back() == '>')
+		if (!found && refMut.alt == '>')
 		{
-			refMut.back() = '<';
+			refMut.alt = '<';
 			_mutations.push_back(refMut);
 		}
 	}
@@ -534,24 +344,29 @@ void Fasta::carefulCompareWithString(std::string seq2)
 	}
 
 	_ref = seq2;
+	
+	int mode = (_banded ? 1 : 0) | (_justify ? 2 : 0);
+	CachedAlignment cached;
+	
+	if (AlignmentCache::cache()->fetch(seq2, seq1, _offset, _diagonal, mode, 
+	                                     &cached))
+	{
+		_mutations = cached.mutations;
+		_left = cached.left;
+		_align = cached.align;
+		_right = cached.right;
+		_problematic |= cached.problematic;
+		_compared = true;
+		updateMutationIds();
+		return;
+	}
 
-	int muts, dels;
-	Alignment ala, alb;
-	setup_alignment(&ala, "");
-	setup_alignment(&alb, "");
-	compare_sequences_and_alignments(seq1, seq2, &muts, &dels, ala, alb, 2);
-	tidy_alignments(ala, alb);
-
-	std::ostringstream ssleft, ssalign, ssright;
 	std::vector<int> indices;
-	print_alignments(ala, alb, ssleft, ssalign, ssright, indices);
 	
-	delete_alignment(&ala);
-	delete_alignment(&alb);
-	
-	_left =   ssleft.str();
-	_align = ssalign.str();
-	_right = ssright.str();
+	if (!_banded || !bandedAlignment(seq1, seq2, indices))
+	{
+		fullAlignment(seq1, seq2, indices);
+	}
 	
 	/*
 	std::cout << _left << std::endl;
@@ -613,7 +428,69 @@ void Fasta::carefulCompareWithString(std::string seq2)
 	
 	_compared = true;
 	
-	FastaMaster::master()->addValue(this, "mutations", mutationSummary());
+	cached.mutations = _mutations;
+	cached.left = _left;
+	cached.align = _align;
+	cached.right = _right;
+	cached.problematic = (plus > 10);
+	AlignmentCache::cache()->store(seq2, seq1, _offset, _diagonal, mode, 
+	                               cached);
+	updateMutationIds();
+}
+
+void Fasta::updateMutationIds()
+{
+	_mutationIds.clear();
+	
+	for (size_t i = 0; i < mutationCount(); i++)
+	{
+		_mutationIds.push_back(MutationTable::table()->intern(mutation(i)));
+	}
+
+	std::sort(_mutationIds.begin(), _mutationIds.end());
+	std::vector<int>::iterator last;
+	last = std::unique(_mutationIds.begin(), _mutationIds.end());
+	_mutationIds.erase(last, _mutationIds.end());
+	_generation++;
+}
+
+bool Fasta::bandedAlignment(std::string seq1, std::string seq2, 
+                            std::vector<int> &indices)
+{
+	BandedAligner aligner(seq1, seq2, _diagonal);
+	
+	if (!aligner.run())
+	{
+		return false;
+	}
+
+	_left = aligner.left();
+	_align = aligner.align();
+	_right = aligner.right();
+	indices = aligner.indices();
+
+	return true;
+}
+
+void Fasta::fullAlignment(std::string seq1, std::string seq2, 
+                          std::vector<int> &indices)
+{
+	int muts, dels;
+	Alignment ala, alb;
+	setup_alignment(&ala, "");
+	setup_alignment(&alb, "");
+	compare_sequences_and_alignments(seq1, seq2, &muts, &dels, ala, alb, 2);
+	tidy_alignments(ala, alb);
+
+	std::ostringstream ssleft, ssalign, ssright;
+	print_alignments(ala, alb, ssleft, ssalign, ssright, indices);
+	
+	delete_alignment(&ala);
+	delete_alignment(&alb);
+	
+	_left =   ssleft.str();
+	_align = ssalign.str();
+	_right = ssright.str();
 }
 
 void Fasta::leftJustifyDeletions()
@@ -627,10 +504,9 @@ void Fasta::leftJustifyDeletions()
 	
 	for (size_t i = 0; i < mutationCount(); i++)
 	{
-		std::string m = mutation(i);
-		int start = residue(m);
+		int start = mutation(i).resi;
 		
-		if (!isDeletion(mutation(i)))
+		if (mutation_kind(mutation(i)) != MutationDeletion)
 		{
 			continue;
 		}
@@ -640,7 +516,7 @@ void Fasta::leftJustifyDeletions()
 
 		for (size_t j = i + 1; j < mutationCount(); j++)
 		{
-			if (!isResidue(mutation(j), end))
+			if (mutation(j).resi != end)
 			{
 				break;
 			}
@@ -698,9 +574,7 @@ void Fasta::leftJustifyDeletions()
 		
 		for (size_t j = i; j < i + count; j++)
 		{
-			std::string mut = _mutations[j];
-			decrementResidue(mut, go_back);
-			_mutations[j] = mut;
+			decrementResidue(_mutations[j], go_back);
 		}
 
 		i += count - 1;
@@ -746,7 +620,7 @@ std::string Fasta::mutationSummary()
 	
 	for (size_t i = 0; i < mutationCount(); i++)
 	{
-		ss << mutation(i) << " ";
+		ss << mutationString(i) << " ";
 	}
 
 	std::string str = ss.str();
@@ -782,14 +656,14 @@ void Fasta::organiseMap()
 
 	for (size_t i = 0; i < mutationCount(); i++)
 	{
-		std::string m = mutation(i);
-		int resi = residue(m);
+		int resi = mutation(i).resi;
+		MutationKind kind = mutation_kind(mutation(i));
 		
-		if (isAddition(m))
+		if (kind == MutationInsertion)
 		{
 			nudgeMap(resi, +1);
 		}
-		else if (isDeletion(m))
+		else if (kind == MutationDeletion)
 		{
 			nudgeMap(resi, -1);
 		}
@@ -812,7 +686,7 @@ void Fasta::sortMutations()
 	{
 		MutInt mi;
 		mi.mut = mutation(i);
-		mi.resi = residue(mi.mut);
+		mi.resi = mi.mut.resi;
 		tmp.push_back(mi);
 	}
 	
@@ -842,12 +716,18 @@ void Fasta::loadMutations(std::string muts, std::string ref)
 			continue;
 		}
 		
-		if (components[i].back() == '+')
+		Mutation m;
+		if (!mutation_from_string(components[i], &m))
+		{
+			continue;
+		}
+		
+		if (m.alt == '+')
 		{
 			plus++;
 		}
 
-		_mutations.push_back(components[i]);
+		_mutations.push_back(m);
 	}
 
 	if (plus > 10)
@@ -856,6 +736,7 @@ void Fasta::loadMutations(std::string muts, std::string ref)
 	}
 	
 	leftJustifyDeletions();
+	updateMutationIds();
 }
 
 void Fasta::setIsProblematic()
@@ -870,38 +751,77 @@ void Fasta::giveMenu(QMenu *m, FastaGroup *g)
 	connect(act, &QAction::triggered, this, &Fasta::setIsProblematic);
 }
 
+/* mutations of mine which the other does not have */
 int Fasta::oneSidedMutations(Fasta *other)
 {
-	int total = mutationCount();
+	const std::vector<int> &mine = _mutationIds;
+	const std::vector<int> &theirs = other->_mutationIds;
+	size_t i = 0; size_t j = 0;
+	int total = 0;
 
-	for (size_t i = 0; i < mutationCount(); i++)
+	while (i < mine.size() && j < theirs.size())
 	{
-		bool found = other->hasMutation(mutation(i));
-		
-		if (found)
+		if (mine[i] < theirs[j])
+		{
+			total++; i++;
+		}
+		else if (mine[i] > theirs[j])
+		{
+			j++;
+		}
+		else
 		{
-			total--;
+			i++; j++;
 		}
 	}
 
+	total += mine.size() - i;
+
 	return total;
 }
 
+/* size of the symmetric difference */
 int Fasta::sharedMutations(Fasta *other)
 {
-	int total = 0;
-	total += oneSidedMutations(other);
-	total += other->oneSidedMutations(this);
+	const std::vector<int> &mine = _mutationIds;
+	const std::vector<int> &theirs = other->_mutationIds;
+	size_t i = 0; size_t j = 0;
+	int common = 0;
 
-	return total;
+	while (i < mine.size() && j < theirs.size())
+	{
+		if (mine[i] < theirs[j])
+		{
+			i++;
+		}
+		else if (mine[i] > theirs[j])
+		{
+			j++;
+		}
+		else
+		{
+			common++; i++; j++;
+		}
+	}
+
+	return mine.size() + theirs.size() - 2 * common;
+}
+
+bool Fasta::hasMutationId(int id)
+{
+	return std::binary_search(_mutationIds.begin(), _mutationIds.end(), id);
 }
 
-bool Fasta::hasMutation(std::string mut)
+bool Fasta::hasMutation(const Mutation &mut)
 {
-	bool found = (std::find(_mutations.begin(), _mutations.end(), mut)
-	              != _mutations.end());
+	int id = MutationTable::table()->find(mut);
 	
-	return found;
+	if (id < 0)
+	{
+		return false;
+	}
+
+	return hasMutationId(id);
 }
 
 std::string Fasta::selectQuery()
@@ -1009,12 +929,9 @@ Fasta *Fasta::fastaFromDatabase(SeqResult &r)
 	f->setCountry(r["country"]);
 	f->setSequence(r["protein_sequence"], true);
 
-	std::ostringstream str;
-	str << std::setfill('0') << std::setw(7) << r["epi_days"];
-
 	FastaMaster::master()->addValue(f, "sample_date", r["sample_date"]);
 	FastaMaster::master()->addValue(f, "mutations", r["mutations"]);
-	FastaMaster::master()->addValue(f, "epi_days", str.str());
+	FastaMaster::master()->addValue(f, "epi_days", r["epi_days"]);
 	
 	if (r["mutations"].length() > 1)
 	{
@@ -22,18 +22,21 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <atomic>
 
 #include "Database.h"
+#include "Mutation.h"
 #include <QTreeWidgetItem>
 
 class FastaGroup;
+class KmerIndex;
 
 typedef std::map<int, int> IntMap;
 typedef std::map<std::string, std::string> KeyValue;
 
 typedef struct
 {
-	std::string mut;
+	Mutation mut;
 	int resi;
 } MutInt;
 
@@ -72,10 +75,6 @@ public:
 	
 	void clearMutations();
 
-	bool findNextORF();
-	bool findNextATG();
-	bool findNextStopCodon();
-	
 	void setOffset(int off)
 	{
 		_offset = off;
@@ -96,6 +95,13 @@ public:
 		_justify = justify;
 	}
 	
+	/* align within a band around the rough alignment's diagonal, rather
+	 * than over the full dynamic programming matrix */
+	static void setBanded(bool banded)
+	{
+		_banded = banded;
+	}
+	
 	unsigned char letter(int i);
 	
 	bool hasResult()
@@ -105,17 +111,35 @@ public:
 
 	int gapCount();
 	
-	std::string mutation(int i)
+	const Mutation &mutation(int i)
 	{
 		return _mutations[i];
 	}
 	
+	std::string mutationString(int i)
+	{
+		return mutation_string(_mutations[i]);
+	}
+	
 	size_t mutationCount()
 	{
 		return _mutations.size();
 	}
 	
-	bool hasMutation(std::string mut);
+	bool hasMutation(const Mutation &mut);
+	bool hasMutationId(int id);
+	
+	/* sorted and without duplicates */
+	const std::vector<int> &mutationIds()
+	{
+		return _mutationIds;
+	}
+	
+	/* changes whenever any sequence's mutations change */
+	static unsigned long mutationGeneration()
+	{
+		return _generation;
+	}
 	
 	bool hasCompared()
 	{
@@ -136,8 +160,11 @@ public:
 	std::string insertQuery();
 	std::string updateQuery();
 
-	void carefulCompareWithFasta(Fasta *f);
+	/* with record = false, only touches this Fasta (and reads f), so
+	 * many may run at once; call recordMutations() afterwards */
+	void carefulCompareWithFasta(Fasta *f, bool record = true);
 	void carefulCompareWithString(std::string seq2);
+	void recordMutations();
 	double compareWithFasta(Fasta *f);
 	void addMutation(char fromWhat, int mut, char towhat);
 
@@ -148,12 +175,16 @@ public:
 	void sortMutations();
 
 	std::string generateSequence();
-	bool roughlyAlign(std::string mine, std::string ref, int minRes);
-	std::string roughCompare(std::string seq, int minRes);
+	bool roughlyAlign(std::string mine, const KmerIndex *ref, int minRes);
+	std::string roughCompare(const KmerIndex *ref, int minRes);
 	void loadMutations(std::string muts, std::string ref);
 
 	void writeAlignment(std::ofstream &file);
 	void leftJustifyDeletions();
+	bool bandedAlignment(std::string seq1, std::string seq2,
+	                     std::vector<int> &indices);
+	void fullAlignment(std::string seq1, std::string seq2,
+	                   std::vector<int> &indices);
 
 	void giveMenu(QMenu *m, FastaGroup *g);
 	
@@ -167,6 +198,17 @@ public:
 		return _lastValue;
 	}
 	
+	/* row in the master's metadata, or -1 if not yet known */
+	int metadataRow()
+	{
+		return _metadataRow;
+	}
+	
+	void setMetadataRow(int row)
+	{
+		_metadataRow = row;
+	}
+	
 	static Fasta *fastaFromDatabase(SeqResult &r);
 signals:
 	void refreshMutations();
@@ -175,7 +217,8 @@ public slots:
 private:
 	void findGlycosylations();
 	void removeDuplicateGlycosylations(Fasta *f);
-	void decrementResidue(std::string &m, int go_back);
+	void decrementResidue(Mutation &m, int go_back);
+	void updateMutationIds();
 	void refreshToolTips();
 	void organiseMap();
 	std::string deletionSequence(int start, int end, int go_back);
@@ -187,10 +230,14 @@ private:
 	bool _problematic;
 	bool _isRef;
 	static bool _justify;
+	static bool _banded;
+	static std::atomic<unsigned long> _generation;
 
 	int _orf;
 	int _offset;
+	int _diagonal;
 	int _stop;
+	int _metadataRow;
 	std::string _name;
 	std::string _seq;
 	std::string _result;
@@ -207,7 +254,8 @@ private:
 	std::string _align;
 	std::string _right;
 	
-	std::vector<std::string> _mutations;
+	std::vector<Mutation> _mutations;
+	std::vector<int> _mutationIds;
 	IntMap _meToRef;
 	IntMap _refToMe;
 };
@@ -17,6 +17,8 @@
 // Please email: vagabond @ hginn.co.uk for more details.
 
 #include <algorithm>
+#include <climits>
+#include <cmath>
 #include <QLineSeries>
 #include <QChart>
 #include <QChartView>
@@ -27,6 +29,8 @@ using namespace QtCharts;
 #include "WidgetFasta.h"
 #include "Fasta.h"
 #include "Ensemble.h"
+#include "Workers.h"
+#include "DistanceMatrix.h"
 #include <QMenu>
 #include <QStyledItemDelegate>
 #include <hcsrc/FileReader.h>
@@ -39,12 +43,23 @@ using namespace QtCharts;
 void FastaGroup::initialise()
 {
 	_permanent = false;
+	_rangeStart = 0;
+	_rangeEnd = 0;
+	_rangeClears = 0;
+	_representative = 0;
+	_statsValid = false;
+	_statsGeneration = 0;
 	_ensemble = _master->getReference();
 
 	Qt::ItemFlags fl = flags();
 	setFlags(fl | Qt::ItemIsEditable);
 }
 
+size_t FastaGroup::_clusterLimit = 20000;
+std::atomic<unsigned long> FastaGroup::_highlightJob(0);
+std::thread *FastaGroup::_highlighter = NULL;
+std::vector<Fasta *> FastaGroup::_highlightAligned;
+
 FastaGroup::FastaGroup(FastaMaster *master) : QTreeWidgetItem(master)
 {
 	_screen = NULL;
@@ -63,9 +78,9 @@ FastaGroup::FastaGroup(FastaGroup *group) : QTreeWidgetItem(group)
 
 std::string FastaGroup::shortText()
 {
-	if (_requirements.length())
+	if (!_requirements.isEmpty())
 	{
-		std::string str = _requirements;
+		std::string str = _requirements.text();
 		replace(str.begin(), str.end(), ',', '+');
 		return str;
 	}
@@ -80,9 +95,9 @@ std::string FastaGroup::generateText()
 	{
 		text = "Group ";
 
-		if (_requirements.length())
+		if (!_requirements.isEmpty())
 		{
-			text += "requiring " + _requirements + " ";
+			text += "requiring " + _requirements.text() + " ";
 		}
 	}
 	else
@@ -119,6 +134,7 @@ void FastaGroup::addFasta(Fasta *f)
 	_nameMap[f->name()] = f;
 	connect(f, &Fasta::refreshMutations, 
 	        this, &FastaGroup::highlight);
+	invalidateStats();
 }
 
 void FastaGroup::removeFasta(Fasta *f)
@@ -131,6 +147,7 @@ void FastaGroup::removeFasta(Fasta *f)
 			           this, &FastaGroup::highlight);
 
 			_fastas.erase(_fastas.begin() + i);
+			invalidateStats();
 		}
 	}
 }
@@ -147,12 +164,15 @@ void FastaGroup::addGroup(FastaGroup *g)
 
 void FastaGroup::highlight()
 {
-	highlightRange(0, 0);
+	startHighlight(0, 0);
 }
 
 void FastaGroup::highlightOne(Fasta *f)
 {
+	cancelHighlight();
 	_ensemble->clearBalls();
+	_rangeStart = 0;
+	_rangeEnd = 0;
 	addHighlight(f);
 	_ensemble->makeBalls();
 }
@@ -168,6 +188,83 @@ void FastaGroup::addHighlight(Fasta *f)
 
 }
 
+void FastaGroup::compareFastas(std::vector<Fasta *> &fastas, Fasta *ref)
+{
+	cancelHighlight();
+	std::vector<Fasta *> aligned = alignFastas(fastas, ref);
+
+	/* the master's value table is not thread-safe */
+	for (size_t i = 0; i < aligned.size(); i++)
+	{
+		aligned[i]->recordMutations();
+	}
+}
+
+std::vector<Fasta *> FastaGroup::alignFastas(std::vector<Fasta *> &fastas, 
+                                             Fasta *ref, 
+                                             CancelCheck cancelled)
+{
+	if (!ref->hasCompared())
+	{
+		ref->carefulCompareWithFasta(ref);
+	}
+
+	std::vector<Fasta *> todo;
+	for (size_t i = 0; i < fastas.size(); i++)
+	{
+		if (!fastas[i]->hasCompared() && fastas[i] != ref)
+		{
+			todo.push_back(fastas[i]);
+		}
+	}
+	
+	std::vector<Fasta *> aligned;
+
+	if (todo.size() == 0)
+	{
+		return aligned;
+	}
+
+	std::cout << "Aligning " << todo.size() << " sequences to " 
+	<< ref->name() << std::endl;
+
+	/* the reference is left alone from here on, so each worker only
+	 * writes to its own Fasta */
+	std::vector<char> done(todo.size(), 0);
+	parallel_for(todo.size(), [&](size_t i, size_t)
+	{
+		if (cancelled())
+		{
+			return;
+		}
+
+		todo[i]->carefulCompareWithFasta(ref, false);
+		done[i] = 1;
+	}, true);
+
+	for (size_t i = 0; i < todo.size(); i++)
+	{
+		if (done[i])
+		{
+			aligned.push_back(todo[i]);
+		}
+	}
+	
+	return aligned;
+}
+
+void FastaGroup::compareAll()
+{
+	cancelHighlight();
+
+	if (fastaCount() == 0)
+	{
+		return;
+	}
+
+	compareFastas(_fastas, fasta(0));
+}
+
 void FastaGroup::highlightRange(int start, int end)
 {
 	if (start < 0)
@@ -186,32 +283,203 @@ void FastaGroup::highlightRange(int start, int end)
 		return;
 	}
 	
+	cancelHighlight();
 	_ensemble->clearBalls();
+	_rangeStart = start;
+	_rangeEnd = end;
+	_rangeClears = _ensemble->clearCount();
 
-	int total = end - start;
-	int max_stages = 100;
-	int per_stage = total / max_stages;
-	int stages = 0;
-	int count = 0;
-	
 	if (fastaCount() == 0)
 	{
 		return;
 	}
 
 	std::cout << "Reference is " << fasta(0)->name() << std::endl;
-	for (size_t j = start; j < (size_t)end; j++)
+	std::vector<Fasta *> range(_fastas.begin() + start, _fastas.begin() + end);
+	compareFastas(range, fasta(0));
+	_ensemble->processFastas(range, _requirements);
+
+	updateText();
+
+	int seqCount = _ensemble->makeBalls();
+	std::cout << "No. sequences displayed: " << seqCount << std::endl;
+}
+
+void FastaGroup::cancelHighlight()
+{
+	_highlightJob++;
+	joinHighlighter();
+}
+
+/* alignments are kept, even if the highlight was cancelled, but only 
+ * recorded here on the GUI thread while the sequences are known to exist */
+void FastaGroup::joinHighlighter()
+{
+	if (_highlighter == NULL)
 	{
-		addHighlight(fasta(j));
-		count++;
+		return;
+	}
+
+	_highlighter->join();
+	delete _highlighter;
+	_highlighter = NULL;
+
+	/* the master's value table is not thread-safe */
+	for (size_t i = 0; i < _highlightAligned.size(); i++)
+	{
+		_highlightAligned[i]->recordMutations();
+	}
+
+	_highlightAligned.clear();
+}
+
+void FastaGroup::startHighlight(int start, int end)
+{
+	cancelHighlight();
+
+	if (start < 0)
+	{
+		start = 0;
+	}
+	
+	if (end == 0 || end > (int)fastaCount())
+	{
+		end = fastaCount();
+	}
 
-		if (count > stages + per_stage)
+	/* nothing worth a thread for */
+	if (fastaCount() == 0 || start > end)
+	{
+		highlightRange(start, end);
+		return;
+	}
+
+	std::cout << "Reference is " << fasta(0)->name() << std::endl;
+	Fasta *ref = fasta(0);
+
+	/* the reference is shown and read elsewhere, so it is only aligned 
+	 * here and only read by the worker */
+	if (!ref->hasCompared())
+	{
+		ref->carefulCompareWithFasta(ref);
+	}
+
+	std::vector<Fasta *> range;
+	for (int i = start; i < end; i++)
+	{
+		if (fasta(i) != ref)
 		{
-			std::cout << "." << std::flush;
-			stages += per_stage;
+			range.push_back(fasta(i));
 		}
 	}
 
+	Requirements requirements = _requirements;
+	Ensemble *ensemble = _ensemble;
+	unsigned long job = _highlightJob;
+
+	_highlighter = new std::thread([=]() mutable
+	{
+		CancelCheck cancelled = [job]() 
+		{
+			return (_highlightJob != job);
+		};
+
+		Highlight h;
+		h.job = job;
+		h.start = start;
+		h.end = end;
+		h.considered = range.size();
+		_highlightAligned = alignFastas(range, ref, cancelled);
+		h.complete = ensemble->countFastas(range, requirements, &h.hist,
+		                                   &h.passed, cancelled);
+
+		/* balls and text must be made on the GUI thread, which drops
+		 * this if the highlight has been cancelled in the meantime */
+		QMetaObject::invokeMethod(this, [this, h]()
+		{
+			finishHighlight(h);
+		}, Qt::QueuedConnection);
+	});
+}
+
+void FastaGroup::finishHighlight(const Highlight &h)
+{
+	/* a cancelled job's sequences may since have been deleted, and its
+	 * alignments were recorded when it was cancelled */
+	if (h.job != _highlightJob)
+	{
+		return;
+	}
+	
+	joinHighlighter();
+
+	if (!h.complete)
+	{
+		return;
+	}
+
+	_ensemble->clearBalls();
+	_rangeStart = h.start;
+	_rangeEnd = h.end;
+	_rangeClears = _ensemble->clearCount();
+	_ensemble->addCounts(h.hist, h.passed, h.considered);
+
+	updateText();
+
+	int seqCount = _ensemble->makeBalls();
+	std::cout << "No. sequences displayed: " << seqCount << std::endl;
+	_master->groupHighlighted(this);
+}
+
+/* as highlightRange, but only adds and removes the sequences which differ
+ * from the range highlighted last time */
+void FastaGroup::moveRange(int start, int end)
+{
+	if (start < 0)
+	{
+		start = 0;
+	}
+	
+	if (end == 0 || end > (int)fastaCount())
+	{
+		end = fastaCount();
+	}
+
+	cancelHighlight();
+
+	/* start afresh if anything else has been highlighted since */
+	if (_rangeEnd <= _rangeStart || start >= _rangeEnd || end <= _rangeStart
+	    || _rangeEnd > (int)fastaCount() || start >= end ||
+	    _rangeClears != _ensemble->clearCount())
+	{
+		highlightRange(start, end);
+		return;
+	}
+
+	std::vector<Fasta *> incoming;
+	for (int j = start; j < end; j++)
+	{
+		if (j < _rangeStart || j >= _rangeEnd)
+		{
+			incoming.push_back(fasta(j));
+		}
+	}
+
+	compareFastas(incoming, fasta(0));
+
+	for (int j = _rangeStart; j < _rangeEnd; j++)
+	{
+		if (j < start || j >= end)
+		{
+			_ensemble->unprocessFasta(fasta(j));
+		}
+	}
+
+	_ensemble->processFastas(incoming, _requirements);
+	
+	_rangeStart = start;
+	_rangeEnd = end;
+
 	updateText();
 
 	int seqCount = _ensemble->makeBalls();
@@ -220,6 +488,13 @@ void FastaGroup::highlightRange(int start, int end)
 
 FastaGroup *FastaGroup::makeRequirementGroup(std::string reqs)
 {
+	return makeRequirementGroup(Requirements(reqs));
+}
+
+FastaGroup *FastaGroup::makeRequirementGroup(const Requirements &reqs)
+{
+	cancelHighlight();
+
 	if (fastaCount() <= 1)
 	{
 		NULL;
@@ -241,12 +516,16 @@ FastaGroup *FastaGroup::makeRequirementGroup(std::string reqs)
 	Fasta *ref = fasta(0);
 	grp->setRequirements(reqs);
 	grp->addFasta(ref);
+	
+	std::vector<int> hits = reqs.select(*mutationIndex());
 
-	for (size_t i = 1; i < fastaCount(); i++)
+	for (size_t i = 0; i < hits.size(); i++)
 	{
-		if (_ensemble->shouldProcess(fasta(i), reqs))
+		Fasta *f = fasta(hits[i]);
+
+		if (hits[i] > 0 && Ensemble::canProcess(f))
 		{
-			grp->addFasta(fasta(i));
+			grp->addFasta(f);
 		}
 	}
 	
@@ -262,32 +541,56 @@ FastaGroup *FastaGroup::makeRequirementGroup(std::string reqs)
 	}
 
 	_master->setCurrentItem(grp);
-	grp->highlightRange();
+	grp->startHighlight();
 	return grp;
 }
 
-void FastaGroup::clearFastas()
+/* puts the existing sequence items in the order of _fastas, after any
+ * subgroups, dropping those for sequences no longer in the group */
+void FastaGroup::reorderItems()
 {
-	for (int i = 0; i < childCount(); i++)
+	std::map<Fasta *, WidgetFasta *> items;
+
+	for (int i = childCount() - 1; i >= 0; i--)
 	{
-		if (dynamic_cast<WidgetFasta *>(child(i)) != NULL)
+		WidgetFasta *wf = dynamic_cast<WidgetFasta *>(child(i));
+
+		if (wf != NULL)
 		{
 			takeChild(i);
-			i--;
+
+			if (items.count(wf->fasta()))
+			{
+				delete items[wf->fasta()];
+			}
+
+			items[wf->fasta()] = wf;
 		}
 	}
+	
+	QList<QTreeWidgetItem *> ordered;
 
 	for (size_t i = 0; i < fastaCount(); i++)
 	{
-		removeFasta(fasta(i));
-		i--;
+		std::map<Fasta *, WidgetFasta *>::iterator it;
+		it = items.find(fasta(i));
+		
+		if (it == items.end())
+		{
+			continue;
+		}
+
+		ordered.push_back(it->second);
+		items.erase(it);
+	}
+	
+	for (std::map<Fasta *, WidgetFasta *>::iterator it = items.begin();
+	     it != items.end(); it++)
+	{
+		delete it->second;
 	}
-}
 
-bool FastaGroup::smaller_value(const FastaGroup::FastaValue &v1, 
-                               const FastaGroup::FastaValue &v2)
-{
-	return (v1.value < v2.value);
+	addChildren(ordered);
 }
 
 void FastaGroup::selectInverse()
@@ -339,6 +642,9 @@ void FastaGroup::giveMenu(QMenu *m)
 	act = m->addAction("Split using cluster4x");
 	connect(act, &QAction::triggered, this, &FastaGroup::prepareCluster4x);
 	
+	act = m->addAction("Align all sequences");
+	connect(act, &QAction::triggered, this, &FastaGroup::compareAll);
+	
 	act = m->addAction("Write alignments to file");
 	connect(act, &QAction::triggered, this, 
 	        [=]() { writeAlignments(""); });
@@ -352,6 +658,8 @@ void FastaGroup::giveMenu(QMenu *m)
 
 void FastaGroup::removeGroup()
 {
+	cancelHighlight();
+
 	if (_group == NULL)
 	{
 		int index = treeWidget()->indexOfTopLevelItem(this);
@@ -365,6 +673,13 @@ void FastaGroup::removeGroup()
 
 void FastaGroup::prepareCluster4x()
 {
+	cancelHighlight();
+
+	if (fastaCount() <= 1)
+	{
+		return;
+	}
+
 	if (_screen != NULL)
 	{
 		_screen->hide();
@@ -379,33 +694,50 @@ void FastaGroup::prepareCluster4x()
 	csv->setList(list);
 	csv->startNewCSV("Sequence similarity");
 	
-	std::vector<Fasta *> copy = _fastas;
-	
-	std::random_shuffle(copy.begin(), copy.end());
-	
-	size_t limit = 1000 + 1;
-	if (limit > copy.size())
+	/* the reference joins every split anyway */
+	std::vector<Fasta *> copy(_fastas.begin() + 1, _fastas.end());
+
+	if (_clusterLimit > 0 && copy.size() > _clusterLimit)
 	{
-		limit = copy.size();
+		std::random_shuffle(copy.begin(), copy.end());
+		copy.resize(_clusterLimit);
 	}
 
-	for (size_t i = 1; i < limit - 1; i++)
+	/* sequences with the same mutations need only be compared once, but
+	 * each is still given to cluster4x, so that haplotypes are weighted
+	 * by how many sequences carry them */
+	HaplotypeTable haps;
+	haps.update(copy);
+	std::vector<std::vector<int> > ids;
+	for (size_t h = 0; h < haps.haplotypeCount(); h++)
 	{
-		for (size_t j = i + 1; j < limit; j++)
-		{
-			double muts = copy[i]->sharedMutations(copy[j]);
-			muts /= 4;
+		ids.push_back(haps.mutationIds(h));
+	}
 
-			double score = exp(-(muts * muts));
-			if (score != score)
-			{
-				score = 0;
-			}
+	std::cout << "Comparing " << ids.size() << " haplotypes of " 
+	<< copy.size() << " sequences for cluster4x" << std::endl;
+	DistanceMatrix matrix(ids);
+	matrix.calculate();
 
-			csv->addValue(copy[i]->name(), copy[j]->name(), score);
-			csv->addValue(copy[j]->name(), copy[i]->name(), score);
+	/* cluster4x takes names, so only make them once */
+	std::vector<std::string> names;
+	for (size_t i = 0; i < copy.size(); i++)
+	{
+		names.push_back(copy[i]->name());
+	}
+
+	for (size_t i = 0; i < copy.size(); i++)
+	{
+		int hi = haps.haplotype(i);
+
+		for (size_t j = i + 1; j < copy.size(); j++)
+		{
+			double score = matrix.similarity(hi, haps.haplotype(j));
+			csv->addValue(names[i], names[j], score);
+			csv->addValue(names[j], names[i], score);
 		}
 	}
+
 	csv->preparePaths();
 	csv->setChosen(0);
 
@@ -498,6 +830,8 @@ void FastaGroup::writeOutFastas(std::string filename)
 
 bool FastaGroup::reorderBy(std::string title)
 {
+	cancelHighlight();
+
 	if (!_master->hasKey(title))
 	{
 		std::cout << "Cannot find title (" << title << 
@@ -511,31 +845,46 @@ bool FastaGroup::reorderBy(std::string title)
 		return false;
 	}
 
-	Fasta *ref = fasta(0);
-	std::vector<FastaGroup::FastaValue> values;
+	MetadataStore *store = _master->metadata();
+	int col = store->column(title);
+
+	/* the reference stays at the top */
+	std::vector<int> rows;
+	std::vector<int> order;
 
 	for (size_t i = 1; i < fastaCount(); i++)
 	{
-		std::string value = _master->valueForKey(fasta(i), title);
-		FastaGroup::FastaValue pair;
-		pair.f = fasta(i);
-		pair.value = value;
-		values.push_back(pair);
+		int row = _master->metadataRow(fasta(i));
+		rows.push_back(row);
+		order.push_back(i);
 		
-		fasta(i)->setLastValue(value);
+		fasta(i)->setLastValue(store->value(row, col));
 	}
-	
-	std::sort(values.begin(), values.end(), FastaGroup::smaller_value);
-	
-	clearFastas();
 
-	addFasta(ref);
+	std::vector<double> rowKeys = store->sortKeys(col, rows);
+	std::vector<double> keys(fastaCount());
 
-	for (size_t i = 0; i < values.size(); i++)
+	for (size_t i = 0; i < rowKeys.size(); i++)
 	{
-		addFasta(values[i].f);
+		/* missing values go first, as empty strings used to */
+		double key = rowKeys[i];
+		keys[i + 1] = (key != key ? -HUGE_VAL : key);
 	}
 	
+	parallel_sort(order, [&](int a, int b)
+	{
+		return keys[a] < keys[b];
+	});
+	
+	std::vector<Fasta *> sorted(1, fasta(0));
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		sorted.push_back(fasta(order[i]));
+	}
+
+	_fastas = sorted;
+	reorderItems();
+	
 	_lastOrdered = title;
 	refreshToolTips();
 	return true;
@@ -592,28 +941,56 @@ void FastaGroup::split(std::string title, int bins, bool reorder)
 
 void FastaGroup::countMutations()
 {
-	if (_mutCounts.size() > 0)
+	cancelHighlight();
+
+	if (_statsValid && _statsGeneration == Fasta::mutationGeneration())
 	{
 		return;
 	}
 
-	for (size_t i = 0; i < fastaCount(); i++)
+	_statsGeneration = Fasta::mutationGeneration();
+	_statsValid = true;
+	_muts.clear();
+	_representative = 0;
+
+	MutationTable *table = MutationTable::table();
+	HaplotypeTable *haps = haplotypes();
+	std::vector<int> present;
+	long total = 0;
+
+	/* carriers of each mutation, once per haplotype */
+	for (size_t h = 0; h < haps->haplotypeCount(); h++)
 	{
-		for (size_t j = 0; j < fasta(i)->mutationCount(); j++)
+		const std::vector<int> &ids = haps->mutationIds(h);
+		
+		for (size_t j = 0; j < ids.size(); j++)
 		{
-			std::string mut = fasta(i)->mutation(j);
-			_mutCounts[mut]++;
+			if (ids[j] >= (int)present.size())
+			{
+				present.resize(ids[j] + 1);
+			}
+
+			present[ids[j]] += haps->weight(h);
 		}
 	}
+
+	for (size_t i = 0; i < fastaCount(); i++)
+	{
+		total += fasta(i)->mutationCount();
+	}
 	
-	std::map<std::string, int>::iterator it;
 	std::vector<MutInt> mints;
 
-	for (it = _mutCounts.begin(); it != _mutCounts.end(); it++)
+	for (size_t id = 0; id < present.size(); id++)
 	{
+		if (present[id] == 0)
+		{
+			continue;
+		}
+
 		MutInt mi;
-		mi.mut = it->first;
-		mi.resi = it->second;
+		mi.mut = table->mutation(id);
+		mi.resi = present[id];
 		mints.push_back(mi);
 	}
 
@@ -623,60 +1000,49 @@ void FastaGroup::countMutations()
 	{
 		_muts.push_back(mints[i].mut);
 	}
-}
 
-int FastaGroup::lostMutations(size_t total)
-{
-	int count = 0;
-	for (size_t i = 0; i < fastaCount(); i++)
+	/* mutations lost by describing every sequence with the first i of
+	 * _muts: each sequence lacks those it doesn't carry and has its own
+	 * left over, so lost(i) = n * i + total - 2 * (carriers of the first
+	 * i). Stop when this no longer falls. */
+	long n = fastaCount();
+	long lost = total;
+	long last_score = LONG_MAX;
+
+	for (size_t i = 0; i < _muts.size(); i++)
 	{
-		Fasta *f = fasta(i);
-		
-		int ticked = 0;
-		for (size_t j = 0; j < total; j++)
+		if (i > 0)
 		{
-			ticked += f->hasMutation(_muts[j]);
+			int id = table->find(_muts[i - 1]);
+			lost += n - 2 * present[id];
 		}
-		
-		int remainder = total - ticked;
-		remainder += (f->mutationCount() - ticked);
-		count += remainder;
-	}
 
-	return count;
-}
-
-std::string FastaGroup::countDescription()
-{
-	countMutations();
-	int last_score = INT_MAX;
-	
-	int result = 0;
-	for (size_t i = 0; i < _muts.size(); i++)
-	{
-		int score = lostMutations(i);
-		
-		if (score < last_score)
+		if (lost < last_score)
 		{
-			last_score = score;
+			last_score = lost;
 		}
 		else
 		{
-			result = i - 1;
-			std::cout << "Stopped on " << result << std::endl;
+			_representative = i - 1;
+			std::cout << "Stopped on " << _representative << std::endl;
 			break;
 		}
 	}
+}
+
+std::string FastaGroup::countDescription()
+{
+	countMutations();
 	
-	if (result == 0)
+	if (_representative <= 0)
 	{
 		return "";
 	}
 	
 	std::string str;
-	for (int i = 0; i < result; i++)
+	for (int i = 0; i < _representative; i++)
 	{
-		str += _muts[i] + " ";
+		str += mutation_string(_muts[i]) + " ";
 	}
 
 	str.pop_back();
@@ -691,15 +1057,12 @@ void FastaGroup::titleLimits(double *min, double *max)
 		return;
 	}
 	
+	MetadataStore *store = _master->metadata();
+	int col = store->column(_lastOrdered);
+	
 	for (size_t i = 0; i < fastaCount(); i++)
 	{
-		std::string str = _master->valueForKey(fasta(i), _lastOrdered);
-		if (str.length() == 0)
-		{
-			continue;
-		}
-
-		double val = atof(str.c_str());
+		double val = store->number(_master->metadataRow(fasta(i)), col);
 		
 		if (val < 0)
 		{
@@ -728,11 +1091,14 @@ void FastaGroup::titleLimits(double *min, double *max)
 
 int FastaGroup::numberBetween(double min, double max)
 {
+	MetadataStore *store = _master->metadata();
+	int col = store->column(_lastOrdered);
+
 	int counts = 0;
 	for (size_t i = 0; i < fastaCount(); i++)
 	{
-		std::string val = _master->valueForKey(fasta(i), _lastOrdered);
-		double dval = atof(val.c_str());
+		double dval = store->number(_master->metadataRow(fasta(i)), col);
+
 		if (dval < max && dval >= min)
 		{
 			counts++;
@@ -874,6 +1240,8 @@ void FastaGroup::writeAlignments(std::string filename)
 		}
 	}
 
+	compareAll();
+
 	std::ofstream aligns;
 	aligns.open(filename);
 	
@@ -22,7 +22,15 @@
 #include <QTreeWidgetItem>
 #include <vector>
 #include <map>
+#include <atomic>
+#include <thread>
 #include <c4xsrc/Screen.h>
+#include "Mutation.h"
+#include "MutationIndex.h"
+#include "HaplotypeTable.h"
+#include "Requirements.h"
+#include "MutationHistogram.h"
+#include "Workers.h"
 
 class QMenu;
 class Fasta;
@@ -56,10 +64,15 @@ public:
 		_permanent = p;
 	}
 
-	void setRequirements(std::string requirements)
+	void setRequirements(const Requirements &requirements)
 	{
 		_requirements = requirements;
 	}
+	
+	const Requirements &requirements()
+	{
+		return _requirements;
+	}
 
 	void removeFasta(Fasta *f);
 	void addFasta(Fasta *f);
@@ -75,6 +88,20 @@ public:
 		return _fastas[i];
 	}
 	
+	MutationIndex *mutationIndex()
+	{
+		cancelHighlight();
+		_index.update(_fastas);
+		return &_index;
+	}
+	
+	HaplotypeTable *haplotypes()
+	{
+		cancelHighlight();
+		_haplotypes.update(_fastas);
+		return &_haplotypes;
+	}
+	
 	std::string lastOrdered()
 	{
 		return _lastOrdered;
@@ -83,15 +110,27 @@ public:
 	void giveMenu(QMenu *m);
 	void highlightOne(Fasta *f);
 	void highlightRange(int start = 0, int end = 0);
+	void moveRange(int start, int end);
+
+	/* as highlightRange, but does the work off the GUI thread and draws
+	 * the balls when done. Any highlight started since cancels it. */
+	void startHighlight(int start = 0, int end = 0);
+	
+	/* stops and waits for any highlight in flight, which may be aligning
+	 * sequences; call on the GUI thread before reading alignments or 
+	 * deleting sequences */
+	static void cancelHighlight();
+
+	static void compareFastas(std::vector<Fasta *> &fastas, Fasta *ref);
+
+	/* as compareFastas, but leaves the new alignments unrecorded so it
+	 * may be called off the GUI thread; returns those it aligned */
+	static std::vector<Fasta *> alignFastas(std::vector<Fasta *> &fastas, 
+	                                        Fasta *ref, CancelCheck 
+	                                        cancelled = never_cancelled);
 	void writeOutFastas(std::string filename);
 	void writeAlignments(std::string filename);
 
-	typedef struct
-	{
-		Fasta *f;
-		std::string value;
-	} FastaValue;
-
 	virtual void finished();
 
 	void refreshToolTips();
@@ -100,37 +139,60 @@ public:
 	std::string countDescription();
 	void fetchValues(std::string title);
 
+	/* most sequences sent to cluster4x, sampled at random; 0 for all */
+	static void setClusterLimit(size_t limit)
+	{
+		_clusterLimit = limit;
+	}
+
 	static void makeCurve(std::vector<FastaGroup *> groups,
 	                      std::string title, std::string filename);
 public slots:
 	void split(std::string title, int bins, bool reorder);
 	FastaGroup *makeRequirementGroup(std::string reqs);
+	FastaGroup *makeRequirementGroup(const Requirements &reqs);
 	bool reorderBy(std::string title);
 	void prepareCluster4x();
 	void selectInverse();
 	void removeGroup();
 	void highlight();
+	void compareAll();
 protected:
 	virtual void setData(int column, int role, const QVariant &value);
 	void setModelData(QWidget *editor, QAbstractItemModel *model, 
                               const QModelIndex &index );
 
 private:
+	typedef struct
+	{
+		unsigned long job;
+		int start;
+		int end;
+		std::vector<Fasta *> passed;
+		MutationHistogram hist;
+		size_t considered;
+		bool complete;
+	} Highlight;
+
+	void finishHighlight(const Highlight &h);
+	static void joinHighlighter();
 	void addHighlight(Fasta *f);
 	void countMutations();
-	int lostMutations(size_t total);
-	static bool smaller_value(const FastaGroup::FastaValue &v1, 
-	                          const FastaGroup::FastaValue &v2);
+	
+	void invalidateStats()
+	{
+		_statsValid = false;
+	}
 
 	void titleLimits(double *min, double *max);
 	int numberBetween(double min, double max);
 	
 	Screen *_screen;
 
-	void clearFastas();
+	void reorderItems();
 
 	std::vector<Fasta *> _fastas;
-	std::string _requirements;
+	Requirements _requirements;
 
 	Ensemble *_ensemble;
 	FastaMaster *_master;
@@ -142,8 +204,26 @@ private:
 	std::string _lastOrdered;
 
 	std::string _customName;
-	std::map<std::string, int> _mutCounts;
-	std::vector<std::string> _muts;
+	/* mutations by decreasing frequency and the number of these which
+	 * best describe the group, kept until the group or its alignments 
+	 * change */
+	std::vector<Mutation> _muts;
+	int _representative;
+	bool _statsValid;
+	unsigned long _statsGeneration;
+
+	int _rangeStart;
+	int _rangeEnd;
+	unsigned long _rangeClears;
+	MutationIndex _index;
+	HaplotypeTable _haplotypes;
+
+	static size_t _clusterLimit;
+	static std::atomic<unsigned long> _highlightJob;
+	static std::thread *_highlighter;
+
+	/* aligned by the highlighter, only read once it has been joined */
+	static std::vector<Fasta *> _highlightAligned;
 };
 
 #endif
@@ -0,0 +1,40 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "FastaListCache.h"
+#include "Fasta.h"
+
+FastaListCache::FastaListCache()
+{
+	_generation = 0;
+	_built = false;
+}
+
+bool FastaListCache::stale(const std::vector<Fasta *> &fastas)
+{
+	if (_built && _generation == Fasta::mutationGeneration() && 
+	    _fastas == fastas)
+	{
+		return false;
+	}
+
+	_fastas = fastas;
+	_generation = Fasta::mutationGeneration();
+	_built = true;
+	return true;
+}
@@ -0,0 +1,44 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__fastalistcache__
+#define __breathalyser__fastalistcache__
+
+#include <vector>
+
+class Fasta;
+
+/* base for anything worked out from a list of sequences, which must be
+ * rebuilt if the list or any of its sequences' mutations change */
+
+class FastaListCache
+{
+public:
+	FastaListCache();
+protected:
+	/* true if the list or any mutations have changed since the last
+	 * call; the new list is then kept in _fastas */
+	bool stale(const std::vector<Fasta *> &fastas);
+
+	std::vector<Fasta *> _fastas;
+private:
+	unsigned long _generation;
+	bool _built;
+};
+
+#endif
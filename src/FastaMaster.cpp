@@ -24,6 +24,11 @@
 #include "Database.h"
 #include "Ensemble.h"
 #include "Fasta.h"
+#include "KmerIndex.h"
+#include "CoOccurrence.h"
+#include "FrameWriter.h"
+#include "MetadataReader.h"
+#include "Workers.h"
 
 #include <iostream>
 #include <fstream>
@@ -40,6 +45,9 @@ FastaMaster *FastaMaster::_master = NULL;
 FastaMaster::FastaMaster(QWidget *parent) : QTreeWidget(parent)
 {
 	_seqView = NULL;
+	_ref = NULL;
+	_structIndex = NULL;
+	_fastaIndex = NULL;
 	_top = new FastaGroup(this);
 	_top->setPermanent(true);
 	addTopLevelItem(_top);
@@ -80,14 +88,15 @@ void FastaMaster::writeOutMutations(std::string filename, bool all)
 	}
 	
 	muts << "sequence_name,mutations" << std::endl;
+	FastaGroup::cancelHighlight();
+	
+	if (_fastas.size())
+	{
+		FastaGroup::compareFastas(*f, _fastas[0]);
+	}
 
 	for (size_t i = 0; i < f->size(); i++)
 	{
-		if (!f->at(i)->hasCompared())
-		{
-			f->at(i)->carefulCompareWithFasta(_fastas[0]);
-		}
-		
 		if (f->at(i)->isProblematic())
 		{
 			continue;
@@ -113,16 +122,16 @@ void FastaMaster::writeOutFastas(std::string filename)
 	}
 }
 
-void FastaMaster::addFasta(Fasta *f)
+void FastaMaster::addFasta(Fasta *f, bool compare)
 {
 	_fastas.push_back(f);
 	_names[f->name()] = f;
 	
-	if (_fastas.size() > 1)
+	if (compare && _fastas.size() > 1)
 	{
 		if (f->hasResult())
 		{
-			f->roughCompare(_fastas[0]->result(), 0);
+			f->roughCompare(fastaIndex(), 0);
 		}
 
 	}
@@ -134,6 +143,51 @@ void FastaMaster::addFasta(Fasta *f)
 	_active = true;
 }
 
+void FastaMaster::addFastas(std::vector<Fasta *> &fastas)
+{
+	size_t first = 0;
+
+	/* the first sequence loaded is the reference for all the others */
+	if (_fastas.size() == 0 && fastas.size() > 0)
+	{
+		addFasta(fastas[0]);
+		first = 1;
+	}
+
+	if (first >= fastas.size())
+	{
+		return;
+	}
+
+	KmerIndex *ref = fastaIndex();
+
+	parallel_for(fastas.size() - first, [&](size_t i, size_t t)
+	{
+		Fasta *f = fastas[first + i];
+
+		if (f->hasResult())
+		{
+			f->roughCompare(ref, 0);
+		}
+	});
+
+	/* tree items and metadata stay on this thread, in loading order */
+	for (size_t i = first; i < fastas.size(); i++)
+	{
+		addFasta(fastas[i], false);
+	}
+}
+
+KmerIndex *FastaMaster::fastaIndex()
+{
+	if (_fastaIndex == NULL && _fastas.size() > 0)
+	{
+		_fastaIndex = new KmerIndex(_fastas[0]->result());
+	}
+
+	return _fastaIndex;
+}
+
 void FastaMaster::loadMetadata(std::string fMetadata)
 {
 	if (!file_exists(fMetadata))
@@ -142,94 +196,61 @@ void FastaMaster::loadMetadata(std::string fMetadata)
 		return;
 	}
 
-	std::string contents = get_file_contents(fMetadata);
-	std::vector<std::string> lines = split(contents, '\n');
+	MetadataReader reader(fMetadata);
+	const std::vector<std::string> &titles = reader.titles();
 	
-	if (lines.size() == 0)
+	if (titles.size() == 0)
 	{
 		std::cout << "File empty" << std::endl;
 		return;
 	}
 	
-	std::string header = lines[0];
-	std::vector<std::string> titles = split(header, ',');
-
-	std::vector<std::string> tmpTitles;
+	std::cout << "We assume " << titles[0] << " is the "\
+	"sequence identifier. If this is not the case, "\
+	"fix and reload" << std::endl;
 	
+	std::vector<int> cols;
 	for (size_t i = 0; i < titles.size(); i++)
 	{
-		tmpTitles.push_back(titles[i]);
-	}
-	
-	if (tmpTitles.size() == 0)
-	{
-		std::cout << "Lines are empty" << std::endl;
-		return;
+		cols.push_back(_metadata.column(titles[i], true));
 	}
 	
-	std::cout << "We assume " << tmpTitles[0] << " is the "\
-	"sequence identifier. If this is not the case, "\
-	"fix and reload" << std::endl;
-	
 	size_t skip = 0;
 	size_t count = 0;
 	
-	for (size_t i = 1; i < lines.size(); i++)
+	reader.readRows([&](std::vector<std::string> &components)
 	{
-		std::vector<std::string> components = split(lines[i], ',');
-		
-		if (components.size() != tmpTitles.size())
-		{
-			std::cout << "Skipping line " << i << " - incorrect number "\
-			" of entries." << std::endl;
-			std::cout << "\t" << lines[i] << std::endl;
-		}
-		
-		KeyValue kv;
-
-		trim(components[0]);
-		
-		if (_nameKeys.count(components[0]))
-		{
-			kv = _nameKeys[components[0]];
-		}
+		int row = _metadata.row(components[0], true);
 
 		for (size_t j = 0; j < components.size(); j++)
 		{
-			trim(components[j]);
-			kv[tmpTitles[j]] = components[j];
+			_metadata.setValue(row, cols[j], components[j]);
 		}
-
-		_nameKeys[components[0]] = kv;
 		
 		if (_names.count(components[0]) == 0)
 		{
 			skip++;
-			continue;
+			return;
 		}
 
 		count++;
+	});
+	
+	if (reader.malformed() > 0)
+	{
+		std::cout << "Skipped " << reader.malformed() << " lines with an "\
+		"incorrect number of entries." << std::endl;
 	}
 	
-	std::cout << "Metadata for " << _nameKeys.size() << 
+	std::cout << "Metadata for " << _metadata.rowCount() << 
 	" fastas in memory." << std::endl;
 	std::cout << "Not assigned " << skip << " fastas not in memory." << std::endl;
 	std::cout << "Loaded metadata for " << count << " fastas." << std::endl;
 	std::cout << "Titles are: " << std::endl;
 	
-	_titles.reserve(_titles.size() + tmpTitles.size());
-	
-	for (size_t i = 0; i < tmpTitles.size(); i++)
-	{
-		if (!hasKey(tmpTitles[i]))
-		{
-			_titles.push_back(tmpTitles[i]);
-		}
-	}
-	
-	for (size_t i = 0; i < _titles.size(); i++)
+	for (size_t i = 0; i < _metadata.columnCount(); i++)
 	{
-		std::cout << "\t" << _titles[i] << std::endl;
+		std::cout << "\t" << _metadata.title(i) << std::endl;
 	}
 	
 	checkForMutations();
@@ -268,89 +289,42 @@ void FastaMaster::mutationScan(std::string list)
 	}
 }
 
-void FastaMaster::mutationScan2D(std::string list)
+void FastaMaster::mutationScan2D(std::string list, std::string filename)
 {
 	std::vector<std::string> bits = split(list, '-');
 
-	if (bits.size() == 1)
-	{
-		return;
-	}
-	
-	std::string filename = "tmp.csv";
-	std::ofstream file;
-	file.open(filename);
-
 	if (bits.size() <= 1)
 	{
 		return;
 	}
-
-	int start = atoi(bits[0].c_str());
-	int end = atoi(bits[1].c_str());
 	
-	std::map<int, FastaGroup *> newGrps;
-	double total = 1;
-	double count = 0;
-
-	for (size_t i = start; i <= end; i++)
+	if (filename.length() == 0)
 	{
-		std::string str = i_to_str(i);
-		FastaGroup *grp = topGroup()->makeRequirementGroup(str);
+		filename = openDialogue(this, "Write co-occurrence file", 
+		                        "Comma separated values (*.csv);;"
+		                        "Binary matrix (*.bin)", false);
 
-		if (grp == NULL || grp->fastaCount() <= 1)
+		if (!checkFileIsValid(filename, true))
 		{
-			continue;
+			return;
 		}
-		
-		total += (grp->fastaCount() - 1);
-		count++;
-		newGrps[i] = grp;
 	}
-	
-	total /= count * 10;
-
-	for (size_t i = start; i <= end - 1; i++)
-	{
-		for (size_t j = i + 1; j <= end; j++)
-		{
-			std::string second = i_to_str(j);
-			
-			if (newGrps[i] == NULL)
-			{
-				continue;
-			}
-
-			FastaGroup *subgrp = newGrps[i]->makeRequirementGroup(second);
-
-			if (subgrp == NULL || subgrp->fastaCount() <= 1)
-			{
-				continue;
-			}
 
-			std::string zi, zj;
-			std::string in = i_to_str(i);
-			std::string jn = i_to_str(j);
-
-			if (i <= 999)
-			{
-				zi = std::string(3 - in.length(), '0');
-			}
-
-			if (j <= 999)
-			{
-				zj = std::string(3 - jn.length(), '0');
-			}
-
-			file << zi << in << "," << zj << jn << "," << subgrp->fastaCount() / total
-			<< std::endl;
-		}
-	}
+	int start = atoi(bits[0].c_str());
+	int end = atoi(bits[1].c_str());
 	
-	file.close();
+	FastaGroup::cancelHighlight();
+	CoOccurrence co(topGroup()->mutationIndex(), start, end);
+	co.calculate();
+	co.write(filename);
 }
 
 void FastaMaster::requireMutation(std::string reqs)
+{
+	requireMutation(Requirements(reqs));
+}
+
+void FastaMaster::requireMutation(const Requirements &reqs)
 {
 	if (selectedGroup() == NULL)
 	{
@@ -362,25 +336,31 @@ void FastaMaster::requireMutation(std::string reqs)
 
 void FastaMaster::checkForMutation(Fasta *f)
 {
+	FastaGroup::cancelHighlight();
+
 	if (fastaCount() == 0)
 	{
 		return;
 	}
 
-	if (_nameKeys[f->name()].count("mutations"))
+	int row = metadataRow(f);
+	int col = _metadata.column("mutations");
+
+	if (_metadata.hasValue(row, col))
 	{
-		std::string val = _nameKeys[f->name()]["mutations"];
+		std::string val = _metadata.value(row, col);
 		f->loadMutations(val, fasta(0)->result());
 		
 		std::string new_val = f->mutationSummary();
-		_nameKeys[f->name()]["mutations"] = new_val;
+		_metadata.setValue(row, col, new_val);
 	}
 }
 
 void FastaMaster::checkForMutations()
 {
-	if (std::find(_titles.begin(), _titles.end(), "mutations") 
-	    != _titles.end())
+	FastaGroup::cancelHighlight();
+
+	if (hasKey("mutations"))
 	{
 		for (size_t i = 0; i < _fastas.size(); i++)
 		{
@@ -393,6 +373,7 @@ void FastaMaster::checkForMutations()
 
 void FastaMaster::clearMutations()
 {
+	FastaGroup::cancelHighlight();
 	_ref->clearBalls();
 	_ref->clearMutations();
 	
@@ -414,7 +395,7 @@ void FastaMaster::highlightMutations()
 	
 	if (selectedGroup())
 	{
-		selectedGroup()->highlightRange();
+		selectedGroup()->startHighlight();
 	}
 }
 
@@ -424,8 +405,11 @@ void FastaMaster::slidingWindowHighlight(StructureView *view,
 {
 	if (requirements.length())
 	{
-		_requirements = requirements;
+		_requirements = Requirements(requirements);
 	}
+	
+	Requirements previous = _top->requirements();
+	_top->setRequirements(_requirements);
 
 	size_t step = window / 10;
 	if (step == 0)
@@ -446,6 +430,7 @@ void FastaMaster::slidingWindowHighlight(StructureView *view,
 	}
 	
 	FileReader::setOutputDirectory(folder);
+	FrameWriter writer;
 
 	for (size_t i = 0; i < _fastas.size(); i += step)
 	{
@@ -455,9 +440,16 @@ void FastaMaster::slidingWindowHighlight(StructureView *view,
 		}
 
 		std::cout << "Highlighting range " << std::endl;
-		_top->highlightRange(i, i + window);
-		view->update();
 		
+		if (count == 0)
+		{
+			_top->highlightRange(i, i + window);
+		}
+		else
+		{
+			_top->moveRange(i, i + window);
+		}
+
 		std::string number = i_to_str(count);
 		count++;
 		std::string zeros;
@@ -495,15 +487,20 @@ void FastaMaster::slidingWindowHighlight(StructureView *view,
 		std::string path = FileReader::addOutputDirectory(filename);
 		std::cout << path << std::endl;
 
-		view->saveImage(path);
+		/* renders into the view's own framebuffer, not the screen */
+		writer.add(view->grabFramebuffer(), path);
 	}
 	
+	writer.finish();
+	view->update();
+	_top->setRequirements(previous);
 	_req = INT_MAX;
 	_aa = '\0';
 }
 
 void FastaMaster::clear()
 {
+	FastaGroup::cancelHighlight();
 	_ref->clearBalls();
 
 	for (size_t i = 1; i < _fastas.size(); i++)
@@ -521,6 +518,9 @@ void FastaMaster::clear()
 	_top->updateText();
 
 	_fastas.clear();
+	
+	delete _fastaIndex;
+	_fastaIndex = NULL;
 }
 
 
@@ -544,13 +544,13 @@ void FastaMaster::makeGroupMenu(QMenu *m)
 	std::cout << "Bleh" << std::endl;
 	QMenu *submenu = m->addMenu(tr("&Relative population CSV..."));
 
-	for (size_t i = 0; i < _titles.size(); i++)
+	for (size_t i = 0; i < titleCount(); i++)
 	{
-		QString qTitle = QString::fromStdString(_titles[i]);
+		QString qTitle = QString::fromStdString(title(i));
 
 		QAction *act = submenu->addAction(qTitle);
 		connect(act, &QAction::triggered, 
-		        this, [=]() { makeCurves(_titles[i]); });
+		        this, [=]() { makeCurves(title(i)); });
 	}
 }
 
@@ -560,13 +560,13 @@ void FastaMaster::makeMenu(QMenu *m)
 
 	QMenu *submenu = m->addMenu(tr("&Reorder by..."));
 	
-	for (size_t i = 0; i < _titles.size(); i++)
+	for (size_t i = 0; i < titleCount(); i++)
 	{
-		QString qTitle = QString::fromStdString(_titles[i]);
+		QString qTitle = QString::fromStdString(title(i));
 
 		QAction *act = submenu->addAction(qTitle);
 		connect(act, &QAction::triggered, 
-		        this, [=]() {reorderBy(_titles[i]);});
+		        this, [=]() {reorderBy(title(i));});
 	}
 
 	std::cout << "Currently loaded: " << _fastas.size() << " fastas." << std::endl;
@@ -577,6 +577,9 @@ void FastaMaster::setReference(Ensemble *e)
 	_ref = e;
 	_top->setEnsemble(_ref);
 	_refSeq = e->generateSequence(_ref->chain(0), &_minRes);
+
+	delete _structIndex;
+	_structIndex = new KmerIndex(_refSeq);
 }
 
 std::vector<FastaGroup *> FastaMaster::selectedGroups()
@@ -627,13 +630,9 @@ Fasta *FastaMaster::selectedFasta()
 
 void FastaMaster::itemClicked(QTreeWidgetItem *item)
 {
+	/* the sequence view reads alignments as well */
+	FastaGroup::cancelHighlight();
 	FastaGroup *grp = selectedGroup();
-	if (grp != NULL)
-	{
-		grp->highlightRange();
-		_seqView->populate(grp);
-	}
-
 	Fasta *f = selectedFasta();
 	
 	if (f != NULL && _seqView != NULL)
@@ -645,45 +644,61 @@ void FastaMaster::itemClicked(QTreeWidgetItem *item)
 			grp->highlightOne(f);
 		}
 	}
+	else if (grp != NULL)
+	{
+		/* sequence view is filled in when the highlight is done */
+		grp->startHighlight();
+	}
 }
 
-bool FastaMaster::fastaHasKey(Fasta *f, std::string key)
+void FastaMaster::groupHighlighted(FastaGroup *grp)
 {
-	if (_nameKeys.count(f->name()) == 0)
+	if (_seqView != NULL && grp == selectedGroup() && selectedFasta() == NULL)
 	{
-		return false;
+		_seqView->populate(grp);
 	}
-	
-	if (_nameKeys[f->name()].count(key) == 0)
+}
+
+int FastaMaster::metadataRow(Fasta *f)
+{
+	int row = f->metadataRow();
+
+	/* rows are never taken away, so only a known one is kept */
+	if (row < 0)
 	{
-		return false;
+		row = _metadata.row(f->name());
+		f->setMetadataRow(row);
 	}
-	
-	return true;
+
+	return row;
+}
+
+bool FastaMaster::fastaHasKey(Fasta *f, std::string key)
+{
+	return _metadata.hasValue(metadataRow(f), _metadata.column(key));
 }
 
 void FastaMaster::addValue(Fasta *f, std::string key, std::string value)
 {
-	_nameKeys[f->name()][key] = value;
-	if (std::find(_titles.begin(), _titles.end(), key) == _titles.end())
+	int row = metadataRow(f);
+
+	if (row < 0)
 	{
-		_titles.push_back(key);
+		row = _metadata.row(f->name(), true);
+		f->setMetadataRow(row);
 	}
+
+	_metadata.setValue(row, _metadata.column(key, true), value);
 }
 
 std::string FastaMaster::valueForKey(Fasta *f, std::string key)
 {
-	if (fastaHasKey(f, key))
-	{
-		return _nameKeys[f->name()][key];
-	}
-	
-	return "";
+	return _metadata.value(metadataRow(f), _metadata.column(key));
 }
 
 bool FastaMaster::hasKey(std::string key)
 {
-	return (std::find(_titles.begin(), _titles.end(), key) != _titles.end());
+	return (_metadata.column(key) >= 0);
 }
 
 bool FastaMaster::isReference(Fasta *f)
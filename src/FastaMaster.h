@@ -22,8 +22,11 @@
 #include <vector>
 #include <string>
 #include <QTreeWidget>
+#include "Requirements.h"
+#include "MetadataStore.h"
 
 class Fasta;
+class KmerIndex;
 class QMenu;
 class Ensemble;
 class Database;
@@ -36,9 +39,6 @@ class FastaGroup;
 class SequenceView;
 class StructureView;
 
-typedef std::map<std::string, std::string> KeyValue;
-typedef std::map<Fasta *, KeyValue> FastaKeys;
-typedef std::map<std::string, KeyValue> NameKeys;
 typedef std::map<std::string, Fasta *> FastaNames;
 
 class FastaMaster : public QTreeWidget
@@ -52,7 +52,8 @@ public:
 		return _active;
 	}
 
-	void addFasta(Fasta *f);
+	void addFasta(Fasta *f, bool compare = true);
+	void addFastas(std::vector<Fasta *> &fastas);
 	
 	size_t fastaCount();
 	Fasta *fasta(int i);
@@ -64,16 +65,36 @@ public:
 	void loadToDatabase(Database *db);
 	void addValue(Fasta *f, std::string key, std::string value);
 	
+	/* for scanning a whole column at once */
+	MetadataStore *metadata()
+	{
+		return &_metadata;
+	}
+	
+	int metadataRow(Fasta *f);
+	
 	void setReference(Ensemble *e);
 	
 	Ensemble *getReference()
 	{
 		return _ref;
 	}
+	
+	/* probes of the reference structure's sequence */
+	KmerIndex *structureIndex()
+	{
+		return _structIndex;
+	}
+
+	/* probes of the reference fasta, fasta(0) */
+	KmerIndex *fastaIndex();
 
 	Fasta *selectedFasta();
 	FastaGroup *selectedGroup();
 	std::vector<FastaGroup *> selectedGroups();
+	
+	/* called on the GUI thread once a group's highlight is drawn */
+	void groupHighlighted(FastaGroup *grp);
 
 	void writeOutFastas(std::string filename);
 	void writeOutMutations(std::string filename, bool all = true);
@@ -98,12 +119,12 @@ public:
 	
 	size_t titleCount()
 	{
-		return _titles.size();
+		return _metadata.columnCount();
 	}
 	
 	std::string title(int i)
 	{
-		return _titles[i];
+		return _metadata.title(i);
 	}
 
 	void slidingWindowHighlight(StructureView *view,
@@ -134,8 +155,9 @@ public:
 	}
 public slots:
 	void requireMutation(std::string reqs);
+	void requireMutation(const Requirements &reqs);
 	void mutationScan(std::string reqs);
-	void mutationScan2D(std::string list);
+	void mutationScan2D(std::string list, std::string filename = "");
 	void highlightMutations();
 	void clearMutations();
 	void clear();
@@ -150,11 +172,12 @@ private:
 	bool _active;
 	Ensemble *_ref;
 	std::string _refSeq;
+	KmerIndex *_structIndex;
+	KmerIndex *_fastaIndex;
 
-	std::vector<std::string> _titles;
 	std::vector<Fasta *> _fastas;
 	std::vector<Fasta *> _subfastas;
-	std::string _requirements;
+	Requirements _requirements;
 	
 	static FastaMaster *_master;
 	FastaGroup *_top;
@@ -162,11 +185,8 @@ private:
 	
 	QChartView *_cView;
 
-//typedef std::map<Fasta *, KeyValue> FastaKeys;
-//typedef std::map<std::string, std::string> KeyValue;
-	
 	FastaNames _names;
-	NameKeys _nameKeys;
+	MetadataStore _metadata;
 };
 
 #endif
@@ -0,0 +1,98 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "FastaReader.h"
+#include <cstring>
+
+FastaReader::FastaReader(std::string filename) : _file(filename)
+{
+	_pos = 0;
+}
+
+bool FastaReader::nextLine(const char **start, size_t *length)
+{
+	if (_pos >= _file.size())
+	{
+		return false;
+	}
+
+	const char *begin = _file.data() + _pos;
+	size_t remaining = _file.size() - _pos;
+	const char *end = (const char *)memchr(begin, '\n', remaining);
+	
+	if (end == NULL)
+	{
+		end = begin + remaining;
+	}
+
+	*start = begin;
+	*length = end - begin;
+	_pos += *length + 1;
+
+	return true;
+}
+
+bool FastaReader::peekHeader()
+{
+	return (_pos < _file.size() && _file.data()[_pos] == '>');
+}
+
+bool FastaReader::nextRecord(std::string &name, std::string &seq)
+{
+	const char *line = NULL;
+	size_t length = 0;
+	
+	name.clear();
+	seq.clear();
+
+	/* skip anything that isn't a proper header line */
+	while (true)
+	{
+		if (!nextLine(&line, &length))
+		{
+			return false;
+		}
+
+		if (length > 2 && line[0] == '>')
+		{
+			break;
+		}
+	}
+
+	name = std::string(line + 1, length - 1);
+
+	if (name.back() == '\n' || name.back() == '\r')
+	{
+		name.pop_back();
+	}
+	
+	/* sequence lines continue until the next header */
+	while (!peekHeader() && nextLine(&line, &length))
+	{
+		seq.append(line, length);
+
+		while (seq.length() && (seq.back() < 'A' || seq.back() > 'Z'))
+		{
+			seq.pop_back();
+		}
+	}
+	
+	_file.release(_pos);
+
+	return true;
+}
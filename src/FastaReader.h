@@ -0,0 +1,48 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__fastareader__
+#define __breathalyser__fastareader__
+
+#include <string>
+#include "MappedFile.h"
+
+/* walks through a fasta file one record at a time, so only the current
+ * header and sequence are ever copied out of the mapped file */
+
+class FastaReader
+{
+public:
+	FastaReader(std::string filename);
+	
+	bool isValid()
+	{
+		return _file.isValid();
+	}
+
+	/* returns false once there are no more records */
+	bool nextRecord(std::string &name, std::string &seq);
+private:
+	bool nextLine(const char **start, size_t *length);
+	bool peekHeader();
+
+	MappedFile _file;
+	size_t _pos;
+};
+
+#endif
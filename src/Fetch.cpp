@@ -311,5 +311,5 @@ void Fetch::processResults(std::vector<SeqResult> results)
 	group->updateText();
 	FastaMaster::master()->addTopLevelItem(group);
 	FastaMaster::master()->setCurrentItem(group);
-	group->highlightRange();
+	group->startHighlight();
 }
@@ -0,0 +1,106 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "FrameWriter.h"
+#include "Workers.h"
+#include <iostream>
+
+FrameWriter::FrameWriter(size_t threads)
+{
+	if (threads == 0)
+	{
+		/* leave a core for rendering */
+		threads = worker_count() > 1 ? worker_count() - 1 : 1;
+	}
+
+	_maxFrames = threads * 2;
+	_busy = 0;
+	_stop = false;
+
+	for (size_t i = 0; i < threads; i++)
+	{
+		_pool.push_back(std::thread(&FrameWriter::work, this));
+	}
+}
+
+FrameWriter::~FrameWriter()
+{
+	finish();
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	
+	_added.notify_all();
+
+	for (size_t i = 0; i < _pool.size(); i++)
+	{
+		_pool[i].join();
+	}
+}
+
+void FrameWriter::add(QImage image, std::string filename)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_taken.wait(lock, [this] { return _frames.size() < _maxFrames; });
+
+	Frame frame;
+	frame.image = image;
+	frame.filename = filename;
+	_frames.push_back(frame);
+
+	lock.unlock();
+	_added.notify_one();
+}
+
+void FrameWriter::finish()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_taken.wait(lock, [this] { return _frames.size() == 0 && _busy == 0; });
+}
+
+void FrameWriter::work()
+{
+	while (true)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_added.wait(lock, [this] { return _stop || _frames.size() > 0; });
+		
+		if (_frames.size() == 0)
+		{
+			return;
+		}
+
+		Frame frame = _frames.front();
+		_frames.pop_front();
+		_busy++;
+		lock.unlock();
+		_taken.notify_all();
+
+		if (!frame.image.save(QString::fromStdString(frame.filename)))
+		{
+			std::cout << "Could not save " << frame.filename << std::endl;
+		}
+		
+		lock.lock();
+		_busy--;
+		lock.unlock();
+		_taken.notify_all();
+	}
+}
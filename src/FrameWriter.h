@@ -0,0 +1,66 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__framewriter__
+#define __breathalyser__framewriter__
+
+#include <QImage>
+#include <string>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/* saves rendered frames on background threads, so that the next frame
+ * can be drawn while earlier ones are still being compressed. At most a
+ * few frames are held at once; add() waits if the queue is full. */
+
+class FrameWriter
+{
+public:
+	FrameWriter(size_t threads = 0);
+	~FrameWriter();
+
+	void add(QImage image, std::string filename);
+	
+	/* returns once every frame added so far has been written */
+	void finish();
+private:
+	FrameWriter(const FrameWriter &other);
+	FrameWriter &operator=(const FrameWriter &other);
+
+	typedef struct
+	{
+		QImage image;
+		std::string filename;
+	} Frame;
+
+	void work();
+
+	std::deque<Frame> _frames;
+	std::vector<std::thread> _pool;
+	std::mutex _mutex;
+	std::condition_variable _added;
+	std::condition_variable _taken;
+	size_t _maxFrames;
+	size_t _busy;
+	bool _stop;
+};
+
+#endif
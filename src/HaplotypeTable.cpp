@@ -0,0 +1,61 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "HaplotypeTable.h"
+#include "Fasta.h"
+
+HaplotypeTable::HaplotypeTable() : FastaListCache()
+{
+
+}
+
+void HaplotypeTable::update(const std::vector<Fasta *> &fastas)
+{
+	if (!stale(fastas))
+	{
+		return;
+	}
+
+	_ids.clear();
+	_members.clear();
+	_haplotypes.clear();
+
+	std::map<std::vector<int>, int> lookup;
+
+	for (size_t i = 0; i < _fastas.size(); i++)
+	{
+		const std::vector<int> &ids = _fastas[i]->mutationIds();
+		std::map<std::vector<int>, int>::iterator it = lookup.find(ids);
+		int h = 0;
+
+		if (it == lookup.end())
+		{
+			h = _ids.size();
+			lookup[ids] = h;
+			_ids.push_back(ids);
+			_members.push_back(std::vector<int>());
+		}
+		else
+		{
+			h = it->second;
+		}
+
+		_members[h].push_back(i);
+		_haplotypes.push_back(h);
+	}
+}
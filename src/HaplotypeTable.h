@@ -0,0 +1,74 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__haplotypetable__
+#define __breathalyser__haplotypetable__
+
+#include <cstddef>
+#include <vector>
+#include <map>
+#include "FastaListCache.h"
+
+class Fasta;
+
+/* sequences grouped by identical sets of mutations, so that work which only
+ * depends on the mutations can be done once per haplotype and weighted by
+ * its number of members. */
+
+class HaplotypeTable : public FastaListCache
+{
+public:
+	HaplotypeTable();
+
+	void update(const std::vector<Fasta *> &fastas);
+
+	size_t haplotypeCount()
+	{
+		return _members.size();
+	}
+	
+	/* sorted mutation ids, as Fasta::mutationIds */
+	const std::vector<int> &mutationIds(int h)
+	{
+		return _ids[h];
+	}
+	
+	/* positions in the list of the sequences with this haplotype */
+	const std::vector<int> &members(int h)
+	{
+		return _members[h];
+	}
+	
+	size_t weight(int h)
+	{
+		return _members[h].size();
+	}
+	
+	/* haplotype of the sequence at this position */
+	int haplotype(int i)
+	{
+		return _haplotypes[i];
+	}
+private:
+
+	std::vector<std::vector<int> > _ids;
+	std::vector<std::vector<int> > _members;
+	std::vector<int> _haplotypes;
+};
+
+#endif
@@ -0,0 +1,120 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "KmerIndex.h"
+#include <climits>
+
+KmerIndex::KmerIndex(std::string ref, int size)
+{
+	_ref = ref;
+	_size = size;
+	_first = INT_MAX;
+	_mask = ((uint64_t)1 << (5 * _size)) - 1;
+
+	for (size_t i = 0; i + _size <= _ref.length(); i += _size / 2)
+	{
+		uint64_t code = 0;
+		bool ok = true;
+
+		for (int j = 0; j < _size; j++)
+		{
+			uint64_t c = letterCode(_ref[i + j]);
+			
+			/* gaps were never used as probes; other symbols can't be 
+			 * packed, so they are left out too */
+			if (c == 0)
+			{
+				ok = false;
+				break;
+			}
+
+			code = (code << 5) | c;
+		}
+		
+		if (!ok)
+		{
+			continue;
+		}
+		
+		/* keep the earliest position if a probe repeats */
+		if (_probes.count(code) == 0)
+		{
+			_probes[code] = i;
+		}
+
+		if ((int)i < _first)
+		{
+			_first = i;
+		}
+	}
+}
+
+bool KmerIndex::anchor(const std::string &query, int *refPos, 
+                       int *queryPos) const
+{
+	int best = INT_MAX;
+	int bestLoc = -1;
+	uint64_t code = 0;
+	int run = 0;
+
+	for (size_t i = 0; i < query.length(); i++)
+	{
+		uint64_t c = letterCode(query[i]);
+		
+		if (c == 0)
+		{
+			run = 0;
+			code = 0;
+			continue;
+		}
+
+		code = ((code << 5) | c) & _mask;
+		run++;
+		
+		if (run < _size)
+		{
+			continue;
+		}
+
+		std::unordered_map<uint64_t, int>::const_iterator it;
+		it = _probes.find(code);
+		
+		if (it == _probes.end() || it->second >= best)
+		{
+			continue;
+		}
+
+		best = it->second;
+		bestLoc = i + 1 - _size;
+		
+		/* nothing can come earlier in the reference than this */
+		if (best == _first)
+		{
+			break;
+		}
+	}
+	
+	if (bestLoc < 0)
+	{
+		return false;
+	}
+
+	*refPos = best;
+	*queryPos = bestLoc;
+	return true;
+}
@@ -0,0 +1,68 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__kmerindex__
+#define __breathalyser__kmerindex__
+
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
+
+/* hash of the probes taken along a reference protein (every half probe
+ * length, skipping any with gaps) so a query only needs one pass over its
+ * own k-mers to find where it anchors to the reference. Read-only once
+ * built, so one index can be shared by every thread. */
+
+class KmerIndex
+{
+public:
+	KmerIndex(std::string ref, int size = 10);
+
+	/* earliest reference probe found in the query, and the first place
+	 * in the query it was found. Returns false if no probe matches. */
+	bool anchor(const std::string &query, int *refPos, int *queryPos) const;
+
+	size_t length() const
+	{
+		return _ref.length();
+	}
+	
+	const std::string &sequence() const
+	{
+		return _ref;
+	}
+private:
+	/* 5 bits per letter, or 0 for anything which is not a capital */
+	static uint64_t letterCode(char ch)
+	{
+		if (ch < 'A' || ch > 'Z')
+		{
+			return 0;
+		}
+
+		return ch - 'A' + 1;
+	}
+
+	std::string _ref;
+	int _size;
+	int _first;
+	uint64_t _mask;
+	std::unordered_map<uint64_t, int> _probes;
+};
+
+#endif
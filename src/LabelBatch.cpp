@@ -0,0 +1,238 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "LabelBatch.h"
+#include "vLabel.h"
+#include "fLabel.h"
+#include <QPainter>
+#include <QFont>
+#include <QFontMetrics>
+#include <algorithm>
+#include <cstring>
+
+/* printable ASCII, which covers everything labels are made from */
+#define FIRST_GLYPH 32
+#define LAST_GLYPH 126
+#define GLYPH_PIXELS 48
+#define ATLAS_COLUMNS 16
+
+QImage LabelBatch::_atlas;
+std::vector<LabelBatch::Glyph> LabelBatch::_glyphs;
+
+LabelBatch::LabelBatch(double size, vec3 offset) : SlipObject()
+{
+	_size = size;
+	_offset = offset;
+	_texture = 0;
+	_dirty = false;
+	_renderType = GL_TRIANGLES;
+	_vString = Label_vsh();
+	_fString = Label_fsh();
+	this->SlipObject::setName("Label batch");
+}
+
+LabelBatch::~LabelBatch()
+{
+	if (_texture != 0)
+	{
+		glDeleteTextures(1, &_texture);
+	}
+}
+
+/* white glyphs on transparent cells, so that labels may be any colour */
+void LabelBatch::makeAtlas()
+{
+	if (_glyphs.size() > 0)
+	{
+		return;
+	}
+
+	QFont font("Helvetica");
+	font.setPixelSize(GLYPH_PIXELS * 3 / 4);
+	QFontMetrics metrics(font);
+
+	int count = LAST_GLYPH - FIRST_GLYPH + 1;
+	int rows = (count + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS;
+	int width = ATLAS_COLUMNS * GLYPH_PIXELS;
+	int height = rows * GLYPH_PIXELS;
+
+	_atlas = QImage(width, height, QImage::Format_RGBA8888);
+	_atlas.fill(Qt::transparent);
+
+	QPainter painter(&_atlas);
+	painter.setFont(font);
+	painter.setPen(Qt::white);
+
+	for (int i = 0; i < count; i++)
+	{
+		QChar ch(FIRST_GLYPH + i);
+		int x = (i % ATLAS_COLUMNS) * GLYPH_PIXELS;
+		int y = (i / ATLAS_COLUMNS) * GLYPH_PIXELS;
+		int advance = std::min(metrics.width(ch), GLYPH_PIXELS);
+
+		painter.drawText(x, y + metrics.ascent(), QString(ch));
+
+		Glyph g;
+		g.advance = advance / (double)GLYPH_PIXELS;
+		g.u0 = x / (double)width;
+		g.u1 = (x + advance) / (double)width;
+		g.v0 = y / (double)height;
+		g.v1 = (y + GLYPH_PIXELS) / (double)height;
+		_glyphs.push_back(g);
+	}
+	
+	painter.end();
+}
+
+void LabelBatch::uploadAtlas()
+{
+	makeAtlas();
+	initializeOpenGLFunctions();
+
+	glGenTextures(1, &_texture);
+	glBindTexture(GL_TEXTURE_2D, _texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _atlas.width(), _atlas.height(),
+	             0, GL_RGBA, GL_UNSIGNED_BYTE, _atlas.constBits());
+}
+
+void LabelBatch::setSlotCount(size_t count)
+{
+	_labels.resize(count);
+}
+
+void LabelBatch::setLabel(size_t slot, vec3 pos, std::string text)
+{
+	if (slot >= _labels.size())
+	{
+		setSlotCount(slot + 1);
+	}
+
+	Label &l = _labels[slot];
+	
+	if (l.text == text && l.pos.x == pos.x && l.pos.y == pos.y && 
+	    l.pos.z == pos.z)
+	{
+		return;
+	}
+
+	l.pos = pos;
+	l.text = text;
+	_dirty = true;
+}
+
+void LabelBatch::removeLabel(size_t slot)
+{
+	if (!hasLabel(slot))
+	{
+		return;
+	}
+
+	_labels[slot].text = "";
+	_dirty = true;
+}
+
+void LabelBatch::clearLabels()
+{
+	_labels.clear();
+	_dirty = true;
+}
+
+void LabelBatch::rebuild()
+{
+	makeAtlas();
+	_vertices.clear();
+	_indices.clear();
+
+	Helen3D::Vertex v;
+	memset(&v, '\0', sizeof(Helen3D::Vertex));
+	v.color[3] = 1;
+	v.extra[2] = _size;
+
+	for (size_t i = 0; i < _labels.size(); i++)
+	{
+		const Label &l = _labels[i];
+		vec3 pos = vec3_add_vec3(l.pos, _offset);
+		pos_from_vec(v.pos, pos);
+		double x = 0;
+
+		for (size_t j = 0; j < l.text.length(); j++)
+		{
+			int c = (unsigned char)l.text[j];
+
+			if (c < FIRST_GLYPH || c > LAST_GLYPH)
+			{
+				c = '?';
+			}
+
+			const Glyph &g = _glyphs[c - FIRST_GLYPH];
+			GLuint begin = _vertices.size();
+			
+			/* corners anticlockwise from bottom left; the atlas runs
+			 * top to bottom */
+			double xs[] = {x, x + g.advance, x + g.advance, x};
+			double ys[] = {0, 0, 1, 1};
+			double us[] = {g.u0, g.u1, g.u1, g.u0};
+			double vs[] = {g.v1, g.v1, g.v0, g.v0};
+
+			for (int k = 0; k < 4; k++)
+			{
+				v.extra[0] = xs[k];
+				v.extra[1] = ys[k];
+				v.tex[0] = us[k];
+				v.tex[1] = vs[k];
+				_vertices.push_back(v);
+			}
+
+			GLuint quad[] = {0, 1, 2, 0, 2, 3};
+			for (int k = 0; k < 6; k++)
+			{
+				_indices.push_back(begin + quad[k]);
+			}
+
+			x += g.advance;
+		}
+	}
+
+	_dirty = false;
+}
+
+void LabelBatch::render(SlipGL *gl)
+{
+	if (_dirty)
+	{
+		rebuild();
+	}
+
+	if (_indices.size() == 0)
+	{
+		return;
+	}
+
+	if (_texture == 0)
+	{
+		uploadAtlas();
+	}
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, _texture);
+	SlipObject::render(gl);
+}
@@ -0,0 +1,81 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__labelbatch__
+#define __breathalyser__labelbatch__
+
+#include <h3dsrc/SlipObject.h>
+#include <QImage>
+#include <string>
+#include <vector>
+
+/* many text labels as one mesh of glyph quads, drawn in a single call from
+ * a glyph atlas which is rasterised once and shared by every batch.
+ * Changing a label only rewrites vertices; the mesh is rebuilt once after
+ * any changes. */
+
+class LabelBatch : public SlipObject
+{
+public:
+	/* size is the glyph height as a fraction of the view's height;
+	 * offset moves every label's anchor, in the model's units */
+	LabelBatch(double size, vec3 offset);
+	virtual ~LabelBatch();
+
+	void setSlotCount(size_t count);
+	void setLabel(size_t slot, vec3 pos, std::string text);
+	void removeLabel(size_t slot);
+	void clearLabels();
+
+	bool hasLabel(size_t slot)
+	{
+		return slot < _labels.size() && _labels[slot].text.length() > 0;
+	}
+
+	virtual void render(SlipGL *gl);
+private:
+	typedef struct
+	{
+		vec3 pos;
+		std::string text;
+	} Label;
+
+	typedef struct
+	{
+		/* in glyph heights */
+		double advance;
+		
+		/* corners in the atlas */
+		double u0, v0, u1, v1;
+	} Glyph;
+
+	static void makeAtlas();
+	void uploadAtlas();
+	void rebuild();
+
+	static QImage _atlas;
+	static std::vector<Glyph> _glyphs;
+
+	std::vector<Label> _labels;
+	vec3 _offset;
+	double _size;
+	GLuint _texture;
+	bool _dirty;
+};
+
+#endif
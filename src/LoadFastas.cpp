@@ -17,6 +17,7 @@
 // Please email: vagabond @ hginn.co.uk for more details.
 
 #include "LoadFastas.h"
+#include "FastaReader.h"
 #include "Fasta.h"
 #include "Main.h"
 
@@ -102,32 +103,6 @@ void LoadFastas::loadFastas(std::string filename, int start, int end)
 	loadSequence(filename, start, end, protein);
 }
 
-std::string makeSeq(std::vector<std::string> &lines, size_t *next)
-{
-	bool found_end = false;
-	std::string seq = "";
-
-	while (!found_end)
-	{
-		seq += lines[*next];
-		
-		while (seq.length() && (seq.back() < 'A' || seq.back() > 'Z'))
-		{
-			seq.pop_back();
-		}
-
-		(*next)++;
-		
-		if (*next >= lines.size() || lines[*next][0] == '>')
-		{
-			(*next)--;
-			return seq;
-		}
-	}
-
-	return "";
-}
-
 void LoadFastas::loadSequence(std::string filename, int start, int end,
                               bool isProtein)
 {
@@ -139,8 +114,12 @@ void LoadFastas::loadSequence(std::string filename, int start, int end,
 		return;
 	}
 
-	std::string results = get_file_contents(filename);
-	std::vector<std::string> lines = split(results, '\n');
+	FastaReader reader(filename);
+	
+	if (!reader.isValid())
+	{
+		return;
+	}
 	
 	std::string src = "unknown";
 	std::string base = getBaseFilename(filename);
@@ -156,24 +135,11 @@ void LoadFastas::loadSequence(std::string filename, int start, int end,
 	
 	std::cout << "Focus: " << start << " " << end << std::endl;
 	int count = 0;
+	std::string name, seq;
+	std::vector<Fasta *> batch;
 	
-	for (size_t i = 0; i < lines.size(); i++)
+	while (reader.nextRecord(name, seq))
 	{
-		if (lines[i].length() <= 2 || lines[i][0] != '>')
-		{
-			continue;
-		}
-
-		std::string name = lines[i].substr(1);
-		
-		if (name.back() == '\n' || name.back() == '\r')
-		{
-			name.pop_back();
-		}
-
-		i++;
-		std::string seq = makeSeq(lines, &i);
-		
 		if (!(start < 0 && end < 0))
 		{
 			if ((int)seq.length() < end)
@@ -202,10 +168,16 @@ void LoadFastas::loadSequence(std::string filename, int start, int end,
 		f->figureOutFromName();
 		std::cout << count << ": Found " << name << std::endl;
 		f->setSequence(seq, isProtein);
+		batch.push_back(f);
 		
-		_main->receiveSequence(f);
+		if (batch.size() >= _batchSize)
+		{
+			_main->receiveSequences(batch);
+			batch.clear();
+		}
 	}
 	
+	_main->receiveSequences(batch);
 	_main->makeSequenceMenu();
 }
 
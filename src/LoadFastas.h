@@ -45,6 +45,9 @@ private:
 	QCheckBox *_isProtein;
 	
 	Main *_main;
+
+	/* sequences translated and aligned together on the worker threads */
+	static const size_t _batchSize = 1000;
 };
 
 #endif
@@ -314,10 +314,16 @@ void Main::makeSequenceMenu()
 
 void Main::receiveSequence(Fasta *f)
 {
-	_ref->processNucleotides(f);
+	_ref->processNucleotides(f, _fMaster->structureIndex());
 	_fMaster->addFasta(f);
 }
 
+void Main::receiveSequences(std::vector<Fasta *> &fastas)
+{
+	_ref->processNucleotides(fastas, _fMaster->structureIndex());
+	_fMaster->addFastas(fastas);
+}
+
 void Main::receiveEnsemble(Ensemble *e)
 {
 	_pdbTree->addTopLevelItem(e);
@@ -76,6 +76,7 @@ public:
 
 	void receiveEnsemble(Ensemble *e);
 	void receiveSequence(Fasta *f);
+	void receiveSequences(std::vector<Fasta *> &fastas);
 	
 	void makeReference(Ensemble *e);
 	void setCommandLineArgs(int argc, char *argv[]);
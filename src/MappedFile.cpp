@@ -0,0 +1,101 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "MappedFile.h"
+
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+MappedFile::MappedFile(std::string filename)
+{
+	_valid = false;
+	_data = NULL;
+	_size = 0;
+	_released = 0;
+	_fd = open(filename.c_str(), O_RDONLY);
+	
+	if (_fd < 0)
+	{
+		std::cout << "Could not open " << filename << std::endl;
+		return;
+	}
+
+	struct stat st;
+	if (fstat(_fd, &st) < 0)
+	{
+		std::cout << "Could not stat " << filename << std::endl;
+		return;
+	}
+
+	_size = st.st_size;
+	_valid = true;
+	
+	if (_size == 0)
+	{
+		return;
+	}
+
+	void *ptr = mmap(NULL, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+
+	if (ptr == MAP_FAILED)
+	{
+		std::cout << "Could not map " << filename << std::endl;
+		_valid = false;
+		_size = 0;
+		return;
+	}
+
+	_data = (char *)ptr;
+	madvise(_data, _size, MADV_SEQUENTIAL);
+}
+
+MappedFile::~MappedFile()
+{
+	if (_data != NULL)
+	{
+		munmap(_data, _size);
+	}
+
+	if (_fd >= 0)
+	{
+		close(_fd);
+	}
+}
+
+void MappedFile::release(size_t upto)
+{
+	if (_data == NULL)
+	{
+		return;
+	}
+
+	size_t page = sysconf(_SC_PAGESIZE);
+	upto -= upto % page;
+	
+	/* not worth a system call for less than a few megabytes */
+	if (upto <= _released + 1024 * page)
+	{
+		return;
+	}
+
+	madvise(_data + _released, upto - _released, MADV_DONTNEED);
+	_released = upto;
+}
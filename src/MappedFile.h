@@ -0,0 +1,61 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__mappedfile__
+#define __breathalyser__mappedfile__
+
+#include <string>
+
+/* read-only memory map of a whole file, so that large inputs can be walked
+ * through without ever holding a copy of the contents on the heap */
+
+class MappedFile
+{
+public:
+	MappedFile(std::string filename);
+	~MappedFile();
+	
+	bool isValid()
+	{
+		return _valid;
+	}
+
+	const char *data()
+	{
+		return _data;
+	}
+	
+	size_t size()
+	{
+		return _size;
+	}
+
+	/* hint that everything before this position will not be read again */
+	void release(size_t upto);
+private:
+	MappedFile(const MappedFile &other);
+	MappedFile &operator=(const MappedFile &other);
+
+	bool _valid;
+	int _fd;
+	char *_data;
+	size_t _size;
+	size_t _released;
+};
+
+#endif
@@ -0,0 +1,265 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "MetadataReader.h"
+#include "Workers.h"
+#include <cstring>
+#include <algorithm>
+
+/* parsed at once by each thread before handing rows back */
+#define BLOCK_SIZE (4 * 1024 * 1024)
+
+MetadataReader::MetadataReader(std::string filename) : _file(filename)
+{
+	_pos = 0;
+	_malformed = 0;
+	_separator = ',';
+	_quoted = false;
+	
+	if (!isValid() || _file.size() == 0)
+	{
+		return;
+	}
+
+	const char *data = _file.data();
+	_quoted = (memchr(data, '"', _file.size()) != NULL);
+	
+	size_t end = lineEnd(0);
+	if (memchr(data, '\t', end) != NULL && memchr(data, ',', end) == NULL)
+	{
+		_separator = '\t';
+	}
+
+	parseRow(_file.size(), &_pos, _titles);
+	
+	if (_titles.size() == 1 && _titles[0].length() == 0)
+	{
+		_titles.clear();
+	}
+}
+
+/* position just after the next newline, or the end of the file */
+size_t MetadataReader::lineEnd(size_t pos)
+{
+	if (pos >= _file.size())
+	{
+		return _file.size();
+	}
+
+	const char *begin = _file.data() + pos;
+	const char *nl = (const char *)memchr(begin, '\n', _file.size() - pos);
+	
+	if (nl == NULL)
+	{
+		return _file.size();
+	}
+	
+	return nl - _file.data() + 1;
+}
+
+static void trim_field(std::string &field)
+{
+	size_t start = field.find_first_not_of(" \t\r");
+	
+	if (start == std::string::npos)
+	{
+		field.clear();
+		return;
+	}
+
+	size_t end = field.find_last_not_of(" \t\r");
+	field = field.substr(start, end - start + 1);
+}
+
+/* reads one record from *pos, stopping at end */
+bool MetadataReader::parseRow(size_t end, size_t *pos, 
+                              std::vector<std::string> &fields)
+{
+	const char *data = _file.data();
+	size_t p = *pos;
+	fields.clear();
+
+	if (p >= end)
+	{
+		return false;
+	}
+
+	std::string field;
+	bool quoted = false;
+	bool wasQuoted = false;
+
+	while (p < end)
+	{
+		char c = data[p];
+		p++;
+		
+		if (quoted)
+		{
+			if (c != '"')
+			{
+				field += c;
+			}
+			else if (p < end && data[p] == '"')
+			{
+				field += '"';
+				p++;
+			}
+			else
+			{
+				quoted = false;
+			}
+
+			continue;
+		}
+
+		if (c == '"' && field.find_first_not_of(" \t") == std::string::npos)
+		{
+			field.clear();
+			quoted = true;
+			wasQuoted = true;
+		}
+		else if (c == _separator || c == '\n')
+		{
+			if (!wasQuoted)
+			{
+				trim_field(field);
+			}
+
+			fields.push_back(field);
+			field.clear();
+			wasQuoted = false;
+			
+			if (c == '\n')
+			{
+				*pos = p;
+				return true;
+			}
+		}
+		else if (!(wasQuoted && (c == '\r' || c == ' ')))
+		{
+			field += c;
+		}
+	}
+	
+	if (!wasQuoted)
+	{
+		trim_field(field);
+	}
+
+	fields.push_back(field);
+	*pos = p;
+
+	return true;
+}
+
+bool MetadataReader::acceptRow(const std::vector<std::string> &fields, 
+                               size_t *bad)
+{
+	if (fields.size() == _titles.size())
+	{
+		return true;
+	}
+
+	/* blank lines aren't worth mentioning */
+	if (fields.size() > 1 || fields[0].length() > 0)
+	{
+		(*bad)++;
+	}
+	
+	return false;
+}
+
+size_t MetadataReader::readRows(RowCallback callback)
+{
+	if (!isValid() || _titles.size() == 0)
+	{
+		return 0;
+	}
+
+	size_t count = 0;
+	std::vector<std::string> fields;
+
+	/* quoted fields may hold newlines, so lines can't be split up */
+	if (_quoted)
+	{
+		size_t released = _pos;
+
+		while (parseRow(_file.size(), &_pos, fields))
+		{
+			if (acceptRow(fields, &_malformed))
+			{
+				callback(fields);
+				count++;
+			}
+			
+			if (_pos - released > BLOCK_SIZE)
+			{
+				_file.release(_pos);
+				released = _pos;
+			}
+		}
+
+		return count;
+	}
+	
+	size_t threads = worker_count();
+
+	while (_pos < _file.size())
+	{
+		/* each thread's share of the block ends on a line boundary */
+		std::vector<size_t> bounds(1, _pos);
+		for (size_t t = 0; t < threads; t++)
+		{
+			size_t next = std::min(bounds.back() + BLOCK_SIZE, _file.size());
+			bounds.push_back(next == _file.size() ? next : lineEnd(next));
+		}
+
+		std::vector<std::vector<std::vector<std::string> > > rows(threads);
+		std::vector<size_t> bad(threads, 0);
+
+		parallel_for(threads, [&](size_t t, size_t)
+		{
+			size_t p = bounds[t];
+			std::vector<std::string> fields;
+
+			while (parseRow(bounds[t + 1], &p, fields))
+			{
+				if (acceptRow(fields, &bad[t]))
+				{
+					rows[t].push_back(fields);
+				}
+			}
+		});
+
+		for (size_t t = 0; t < threads; t++)
+		{
+			for (size_t i = 0; i < rows[t].size(); i++)
+			{
+				callback(rows[t][i]);
+				count++;
+			}
+
+			_malformed += bad[t];
+		}
+
+		_pos = bounds.back();
+		_file.release(_pos);
+	}
+
+	return count;
+}
@@ -0,0 +1,72 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__metadatareader__
+#define __breathalyser__metadatareader__
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "MappedFile.h"
+
+/* streams rows of a comma- or tab-separated metadata file straight out of
+ * the mapped file. Fields may be quoted, with "" for a quote inside. If the
+ * file has no quotes at all, blocks of lines are split up and parsed 
+ * across all the cores. */
+
+class MetadataReader
+{
+public:
+	typedef std::function<void (std::vector<std::string> &)> RowCallback;
+
+	MetadataReader(std::string filename);
+	
+	bool isValid()
+	{
+		return _file.isValid();
+	}
+
+	/* from the first line, which also decides the separator */
+	const std::vector<std::string> &titles()
+	{
+		return _titles;
+	}
+
+	/* calls back with every row with as many fields as titles, in file 
+	 * order and on the calling thread. Returns number of rows. */
+	size_t readRows(RowCallback callback);
+	
+	/* rows skipped for having the wrong number of fields */
+	size_t malformed()
+	{
+		return _malformed;
+	}
+private:
+	bool parseRow(size_t end, size_t *pos, std::vector<std::string> &fields);
+	bool acceptRow(const std::vector<std::string> &fields, size_t *bad);
+	size_t lineEnd(size_t pos);
+
+	MappedFile _file;
+	std::vector<std::string> _titles;
+	char _separator;
+	bool _quoted;
+	size_t _pos;
+	size_t _malformed;
+};
+
+#endif
@@ -0,0 +1,463 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "MetadataStore.h"
+#include <cstdlib>
+#include <cctype>
+#include <cmath>
+#include <algorithm>
+
+/* distinct values a column may have before it is a candidate for 
+ * keeping flat, which it becomes if most of its values are distinct */
+#define FLAT_THRESHOLD 4096
+
+MetadataStore::MetadataStore()
+{
+
+}
+
+void MetadataStore::clear()
+{
+	_names.clear();
+	_rows.clear();
+	_columns.clear();
+	_titles.clear();
+}
+
+int MetadataStore::row(const std::string &name, bool create)
+{
+	std::unordered_map<std::string, int>::iterator it = _rows.find(name);
+	
+	if (it != _rows.end())
+	{
+		return it->second;
+	}
+	
+	if (!create)
+	{
+		return -1;
+	}
+
+	int r = _names.size();
+	_names.push_back(name);
+	_rows[name] = r;
+
+	return r;
+}
+
+int MetadataStore::column(const std::string &title, bool create)
+{
+	std::unordered_map<std::string, int>::iterator it = _titles.find(title);
+	
+	if (it != _titles.end())
+	{
+		return it->second;
+	}
+	
+	if (!create)
+	{
+		return -1;
+	}
+
+	int c = _columns.size();
+	_columns.push_back(Column());
+	_columns[c].title = title;
+	_columns[c].type = MetaEmpty;
+	_columns[c].flat = false;
+	_titles[title] = c;
+
+	for (int i = 0; i <= MetaString; i++)
+	{
+		_columns[c].typeCounts[i] = 0;
+	}
+
+	return c;
+}
+
+/* days from 1970-01-01 in the proleptic Gregorian calendar */
+static long days_from_civil(long y, long m, long d)
+{
+	y -= (m <= 2);
+	long era = (y >= 0 ? y : y - 399) / 400;
+	long yoe = y - era * 400;
+	long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+	return era * 146097 + doe - 719468;
+}
+
+/* as YYYY-MM-DD */
+static bool parse_date(const std::string &value, double *number)
+{
+	if (value.length() != 10 || value[4] != '-' || value[7] != '-')
+	{
+		return false;
+	}
+	
+	for (size_t i = 0; i < value.length(); i++)
+	{
+		if (i != 4 && i != 7 && !isdigit(value[i]))
+		{
+			return false;
+		}
+	}
+
+	long y = atol(value.substr(0, 4).c_str());
+	long m = atol(value.substr(5, 2).c_str());
+	long d = atol(value.substr(8, 2).c_str());
+	
+	if (m < 1 || m > 12 || d < 1 || d > 31)
+	{
+		return false;
+	}
+
+	*number = days_from_civil(y, m, d);
+	return true;
+}
+
+MetadataStore::ColumnType MetadataStore::classify(const std::string &value, 
+                                                  double *number)
+{
+	*number = NAN;
+
+	if (value.length() == 0)
+	{
+		return MetaEmpty;
+	}
+	
+	if (parse_date(value, number))
+	{
+		return MetaDate;
+	}
+
+	const char *start = value.c_str();
+	char *end = NULL;
+	double d = strtod(start, &end);
+	
+	if (end == start || *end != '\0' || isspace(value[0]))
+	{
+		return MetaString;
+	}
+
+	*number = d;
+
+	if (value.find_first_not_of("+-0123456789") == std::string::npos)
+	{
+		return MetaInteger;
+	}
+
+	return MetaFloat;
+}
+
+MetadataStore::ColumnType MetadataStore::widen(ColumnType a, ColumnType b)
+{
+	if (a == b || b == MetaEmpty)
+	{
+		return a;
+	}
+
+	if (a == MetaEmpty)
+	{
+		return b;
+	}
+	
+	if ((a == MetaInteger && b == MetaFloat) || 
+	    (a == MetaFloat && b == MetaInteger))
+	{
+		return MetaFloat;
+	}
+
+	return MetaString;
+}
+
+/* from the types of the values currently held */
+void MetadataStore::retype(Column &c)
+{
+	c.type = MetaEmpty;
+
+	for (int i = 0; i <= MetaString; i++)
+	{
+		if (c.typeCounts[i] > 0)
+		{
+			c.type = widen(c.type, (ColumnType)i);
+		}
+	}
+}
+
+int MetadataStore::intern(Column &c, const std::string &value)
+{
+	std::unordered_map<std::string, int>::iterator it = c.lookup.find(value);
+
+	if (it != c.lookup.end())
+	{
+		return it->second;
+	}
+
+	double number = NAN;
+	ColumnType type = classify(value, &number);
+	int code = c.dictionary.size();
+	
+	if (c.unused.size())
+	{
+		code = c.unused.back();
+		c.unused.pop_back();
+		c.dictionary[code] = value;
+		c.numbers[code] = number;
+		c.types[code] = type;
+		c.uses[code] = 0;
+	}
+	else
+	{
+		c.dictionary.push_back(value);
+		c.numbers.push_back(number);
+		c.types.push_back(type);
+		c.uses.push_back(0);
+	}
+
+	c.lookup[value] = code;
+	return code;
+}
+
+/* one fewer row uses this code, which is freed when none do */
+void MetadataStore::release(Column &c, int code)
+{
+	c.uses[code]--;
+	c.typeCounts[c.types[code]]--;
+	
+	if (c.uses[code] > 0)
+	{
+		return;
+	}
+
+	c.lookup.erase(c.dictionary[code]);
+	std::string().swap(c.dictionary[code]);
+	c.unused.push_back(code);
+}
+
+void MetadataStore::setFlatValue(Column &c, int row, const std::string &value)
+{
+	if ((int)c.rowTypes.size() <= row)
+	{
+		c.strings.resize(_names.size());
+		c.rowNumbers.resize(_names.size(), NAN);
+		c.rowTypes.resize(_names.size(), -1);
+	}
+	
+	if (c.rowTypes[row] >= 0)
+	{
+		c.typeCounts[c.rowTypes[row]]--;
+	}
+
+	double number = NAN;
+	ColumnType type = classify(value, &number);
+	c.strings[row] = value;
+	c.rowNumbers[row] = number;
+	c.rowTypes[row] = type;
+	c.typeCounts[type]++;
+}
+
+/* moves a dictionary coded column to one value per row */
+void MetadataStore::flatten(Column &c)
+{
+	size_t rows = c.codes.size();
+	c.strings.resize(rows);
+	c.rowNumbers.resize(rows, NAN);
+	c.rowTypes.resize(rows, -1);
+
+	for (size_t i = 0; i < rows; i++)
+	{
+		int code = c.codes[i];
+
+		if (code >= 0)
+		{
+			c.strings[i] = c.dictionary[code];
+			c.rowNumbers[i] = c.numbers[code];
+			c.rowTypes[i] = c.types[code];
+		}
+	}
+
+	c.flat = true;
+	std::vector<int>().swap(c.codes);
+	std::vector<std::string>().swap(c.dictionary);
+	std::vector<double>().swap(c.numbers);
+	std::vector<ColumnType>().swap(c.types);
+	std::vector<int>().swap(c.uses);
+	std::vector<int>().swap(c.unused);
+	std::unordered_map<std::string, int>().swap(c.lookup);
+}
+
+void MetadataStore::setValue(int row, int col, const std::string &value)
+{
+	Column &c = _columns[col];
+	
+	if (c.flat)
+	{
+		setFlatValue(c, row, value);
+		retype(c);
+		return;
+	}
+
+	if ((int)c.codes.size() <= row)
+	{
+		c.codes.resize(_names.size(), -1);
+	}
+	
+	int old = c.codes[row];
+	
+	if (old >= 0 && c.dictionary[old] == value)
+	{
+		return;
+	}
+
+	int code = intern(c, value);
+	c.uses[code]++;
+	c.typeCounts[c.types[code]]++;
+	c.codes[row] = code;
+
+	if (old >= 0)
+	{
+		release(c, old);
+	}
+
+	retype(c);
+	
+	size_t held = 0;
+	for (int i = 0; i <= MetaString; i++)
+	{
+		held += c.typeCounts[i];
+	}
+
+	if (c.lookup.size() > FLAT_THRESHOLD && c.lookup.size() * 2 > held)
+	{
+		flatten(c);
+	}
+}
+
+int MetadataStore::code(int row, int col) const
+{
+	if (row < 0 || col < 0)
+	{
+		return -1;
+	}
+
+	const Column &c = _columns[col];
+	
+	if (row >= (int)c.codes.size())
+	{
+		return -1;
+	}
+	
+	return c.codes[row];
+}
+
+bool MetadataStore::hasValue(int row, int col) const
+{
+	if (row >= 0 && col >= 0 && _columns[col].flat)
+	{
+		const Column &c = _columns[col];
+		return (row < (int)c.rowTypes.size() && c.rowTypes[row] >= 0);
+	}
+
+	return (code(row, col) >= 0);
+}
+
+const std::string &MetadataStore::value(int row, int col) const
+{
+	if (!hasValue(row, col))
+	{
+		return _empty;
+	}
+	
+	const Column &c = _columns[col];
+	
+	if (c.flat)
+	{
+		return c.strings[row];
+	}
+	
+	return c.dictionary[c.codes[row]];
+}
+
+double MetadataStore::number(int row, int col) const
+{
+	if (!hasValue(row, col))
+	{
+		return NAN;
+	}
+	
+	const Column &c = _columns[col];
+	
+	if (c.flat)
+	{
+		return c.rowNumbers[row];
+	}
+	
+	return c.numbers[c.codes[row]];
+}
+
+std::vector<double> MetadataStore::sortKeys(int col, 
+                                            const std::vector<int> &rows) const
+{
+	std::vector<double> keys(rows.size(), NAN);
+
+	if (col < 0)
+	{
+		return keys;
+	}
+
+	const Column &c = _columns[col];
+
+	if (c.type == MetaInteger || c.type == MetaFloat || c.type == MetaDate)
+	{
+		for (size_t i = 0; i < rows.size(); i++)
+		{
+			keys[i] = number(rows[i], col);
+		}
+
+		return keys;
+	}
+	
+	/* otherwise rank the strings, equal ones sharing a rank */
+	std::vector<int> order;
+	for (size_t i = 0; i < rows.size(); i++)
+	{
+		if (value(rows[i], col).length() > 0)
+		{
+			order.push_back(i);
+		}
+	}
+
+	std::sort(order.begin(), order.end(), [&](int a, int b)
+	{
+		return value(rows[a], col) < value(rows[b], col);
+	});
+
+	int rank = 0;
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		if (i > 0 && value(rows[order[i]], col) != 
+		    value(rows[order[i - 1]], col))
+		{
+			rank++;
+		}
+
+		keys[order[i]] = rank;
+	}
+
+	return keys;
+}
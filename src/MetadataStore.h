@@ -0,0 +1,129 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__metadatastore__
+#define __breathalyser__metadatastore__
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/* metadata by sequence name and title. Each name is given a dense row and
+ * each title a column, which holds one code per row into its own 
+ * dictionary of distinct values. Columns where most values are distinct
+ * (e.g. mutations) are instead kept flat, one value per row. Values are 
+ * parsed once as they arrive, and each column takes the narrowest type 
+ * fitting all the values it currently holds. */
+
+class MetadataStore
+{
+public:
+	typedef enum
+	{
+		MetaEmpty,
+		MetaInteger,
+		MetaFloat,
+		MetaDate,
+		MetaString
+	} ColumnType;
+
+	MetadataStore();
+	
+	void clear();
+
+	/* returns -1 if unknown, unless asked to create */
+	int row(const std::string &name, bool create = false);
+	int column(const std::string &title, bool create = false);
+	
+	size_t rowCount() const
+	{
+		return _names.size();
+	}
+	
+	size_t columnCount() const
+	{
+		return _columns.size();
+	}
+	
+	const std::string &title(int col) const
+	{
+		return _columns[col].title;
+	}
+
+	ColumnType type(int col) const
+	{
+		return _columns[col].type;
+	}
+
+	void setValue(int row, int col, const std::string &value);
+	bool hasValue(int row, int col) const;
+	
+	/* empty if there is none */
+	const std::string &value(int row, int col) const;
+
+	/* numbers as they are, dates as days since 1970-01-01, otherwise NaN */
+	double number(int row, int col) const;
+	
+	/* a key for each of these rows, in the column type's order: by value 
+	 * for numbers and dates, otherwise by string. NaN for no value. */
+	std::vector<double> sortKeys(int col, const std::vector<int> &rows) const;
+private:
+	typedef struct
+	{
+		std::string title;
+		ColumnType type;
+		
+		/* how many rows hold a value of each type */
+		size_t typeCounts[MetaString + 1];
+		bool flat;
+
+		/* per row, while dictionary coded */
+		std::vector<int> codes;
+
+		/* per code, with unused codes freed for reuse */
+		std::vector<std::string> dictionary;
+		std::vector<double> numbers;
+		std::vector<ColumnType> types;
+		std::vector<int> uses;
+		std::vector<int> unused;
+		std::unordered_map<std::string, int> lookup;
+		
+		/* per row, once flat; types are -1 for no value */
+		std::vector<std::string> strings;
+		std::vector<double> rowNumbers;
+		std::vector<signed char> rowTypes;
+	} Column;
+	
+	static ColumnType classify(const std::string &value, double *number);
+	static ColumnType widen(ColumnType a, ColumnType b);
+	
+	int code(int row, int col) const;
+	int intern(Column &c, const std::string &value);
+	void release(Column &c, int code);
+	void setFlatValue(Column &c, int row, const std::string &value);
+	void flatten(Column &c);
+	void retype(Column &c);
+
+	std::vector<std::string> _names;
+	std::unordered_map<std::string, int> _rows;
+	std::vector<Column> _columns;
+	std::unordered_map<std::string, int> _titles;
+	std::string _empty;
+};
+
+#endif
@@ -0,0 +1,215 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "Mutation.h"
+#include <sstream>
+#include <cstdlib>
+
+std::string mutation_string(const Mutation &m)
+{
+	std::ostringstream ss;
+	ss << m.ref << m.resi << m.alt;
+	return ss.str();
+}
+
+bool mutation_from_string(const std::string &str, Mutation *m)
+{
+	if (str.length() < 3)
+	{
+		return false;
+	}
+	
+	char *end = NULL;
+	const char *digits = &str.c_str()[1];
+	long resi = strtol(digits, &end, 10);
+	
+	/* needs a number, followed by exactly one character */
+	if (end == digits || end != &str.c_str()[str.length() - 1])
+	{
+		return false;
+	}
+	
+	*m = make_mutation(str[0], resi, str.back());
+	return true;
+}
+
+MutationTable *MutationTable::table()
+{
+	static MutationTable table;
+	return &table;
+}
+
+MutationTable::MutationTable()
+{
+	for (int i = 0; i < _maxChunks; i++)
+	{
+		_chunks[i] = NULL;
+	}
+
+	Lookup *lookup = new Lookup();
+	lookup->capacity = 1024;
+	lookup->entries = new Slot[lookup->capacity];
+
+	for (size_t i = 0; i < lookup->capacity; i++)
+	{
+		lookup->entries[i].key = 0;
+		lookup->entries[i].id = -1;
+	}
+
+	_size = 0;
+	_lookup = lookup;
+}
+
+/* never zero, which marks an empty slot */
+uint64_t MutationTable::key(const Mutation &m)
+{
+	uint64_t k = (uint32_t)m.resi;
+	k = (k << 8) | (unsigned char)m.ref;
+	k = (k << 8) | (unsigned char)m.alt;
+	return k + 1;
+}
+
+int MutationTable::search(const Lookup *lookup, uint64_t key)
+{
+	size_t mask = lookup->capacity - 1;
+	size_t i = (key * 0x9e3779b97f4a7c15ULL) >> 20;
+
+	for (;; i++)
+	{
+		const Slot &slot = lookup->entries[i & mask];
+		uint64_t k = slot.key.load(std::memory_order_acquire);
+
+		if (k == 0)
+		{
+			return -1;
+		}
+		else if (k == key)
+		{
+			return slot.id.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+/* the id is written before the key, so readers which see the key see it */
+void MutationTable::place(Lookup *lookup, uint64_t key, int id)
+{
+	size_t mask = lookup->capacity - 1;
+	size_t i = (key * 0x9e3779b97f4a7c15ULL) >> 20;
+
+	while (lookup->entries[i & mask].key.load(std::memory_order_relaxed) != 0)
+	{
+		i++;
+	}
+
+	Slot &slot = lookup->entries[i & mask];
+	slot.id.store(id, std::memory_order_relaxed);
+	slot.key.store(key, std::memory_order_release);
+}
+
+/* kept at most half full; called with the lock held */
+void MutationTable::grow()
+{
+	Lookup *old = _lookup.load(std::memory_order_relaxed);
+	Lookup *lookup = new Lookup();
+	lookup->capacity = old->capacity * 2;
+	lookup->entries = new Slot[lookup->capacity];
+
+	for (size_t i = 0; i < lookup->capacity; i++)
+	{
+		lookup->entries[i].key = 0;
+		lookup->entries[i].id = -1;
+	}
+
+	for (size_t i = 0; i < old->capacity; i++)
+	{
+		uint64_t k = old->entries[i].key.load(std::memory_order_relaxed);
+
+		if (k != 0)
+		{
+			place(lookup, k, old->entries[i].id.load(std::memory_order_relaxed));
+		}
+	}
+
+	_lookup.store(lookup, std::memory_order_release);
+	_retired.push_back(old);
+}
+
+int MutationTable::intern(const Mutation &m)
+{
+	uint64_t k = key(m);
+	int id = search(_lookup.load(std::memory_order_acquire), k);
+
+	if (id >= 0)
+	{
+		return id;
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	Lookup *lookup = _lookup.load(std::memory_order_relaxed);
+	id = search(lookup, k);
+
+	if (id >= 0)
+	{
+		return id;
+	}
+	
+	size_t n = _size.load(std::memory_order_relaxed);
+	size_t chunk = n >> _chunkBits;
+
+	if (chunk >= (size_t)_maxChunks)
+	{
+		abort();
+	}
+	
+	if (_chunks[chunk].load(std::memory_order_relaxed) == NULL)
+	{
+		_chunks[chunk].store(new Mutation[1 << _chunkBits], 
+		                     std::memory_order_release);
+	}
+
+	Mutation *chunks = _chunks[chunk].load(std::memory_order_relaxed);
+	chunks[n & ((1 << _chunkBits) - 1)] = m;
+	_size.store(n + 1, std::memory_order_release);
+	id = n;
+
+	if ((n + 1) * 2 > lookup->capacity)
+	{
+		grow();
+		lookup = _lookup.load(std::memory_order_relaxed);
+	}
+
+	place(lookup, k, id);
+	return id;
+}
+
+int MutationTable::find(const Mutation &m)
+{
+	return search(_lookup.load(std::memory_order_acquire), key(m));
+}
+
+/* ids only come from intern, which has stored the mutation by then */
+Mutation MutationTable::mutation(int id)
+{
+	Mutation *chunk = _chunks[id >> _chunkBits].load(std::memory_order_acquire);
+	return chunk[id & ((1 << _chunkBits) - 1)];
+}
+
+size_t MutationTable::size()
+{
+	return _size.load(std::memory_order_acquire);
+}
@@ -0,0 +1,160 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__mutation__
+#define __breathalyser__mutation__
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+/* a single difference from the reference, e.g. N501Y, in eight bytes.
+ * alt is the replacement amino acid, or one of:
+ * '+' insertion (ref is then the inserted residue), '-' deletion,
+ * '>' glycosylation site, '<' glycosylation site lost from reference */
+
+typedef struct
+{
+	int resi;
+	char ref;
+	char alt;
+} Mutation;
+
+typedef enum
+{
+	MutationSubstitution,
+	MutationInsertion,
+	MutationDeletion,
+	MutationGlycosylation,
+	MutationLostGlycosylation,
+} MutationKind;
+
+inline Mutation make_mutation(char ref, int resi, char alt)
+{
+	Mutation m;
+	m.resi = resi;
+	m.ref = ref;
+	m.alt = alt;
+	return m;
+}
+
+inline bool operator==(const Mutation &a, const Mutation &b)
+{
+	return (a.resi == b.resi && a.ref == b.ref && a.alt == b.alt);
+}
+
+inline bool operator!=(const Mutation &a, const Mutation &b)
+{
+	return !(a == b);
+}
+
+inline bool operator<(const Mutation &a, const Mutation &b)
+{
+	if (a.resi != b.resi)
+	{
+		return a.resi < b.resi;
+	}
+	if (a.ref != b.ref)
+	{
+		return a.ref < b.ref;
+	}
+
+	return a.alt < b.alt;
+}
+
+inline MutationKind mutation_kind(const Mutation &m)
+{
+	switch (m.alt)
+	{
+		case '+':
+		return MutationInsertion;
+		case '-':
+		return MutationDeletion;
+		case '>':
+		return MutationGlycosylation;
+		case '<':
+		return MutationLostGlycosylation;
+		default:
+		return MutationSubstitution;
+	}
+}
+
+inline bool is_glycosylation(const Mutation &m)
+{
+	return (m.alt == '>' || m.alt == '<');
+}
+
+/* only for display and export */
+std::string mutation_string(const Mutation &m);
+
+/* reads e.g. "N501Y"; returns false if it doesn't look like a mutation */
+bool mutation_from_string(const std::string &str, Mutation *m);
+
+/* hands out one small integer per distinct mutation, shared by all
+ * sequences, so that mutations can be compared and counted as IDs. Only
+ * interning new mutations takes the lock: mutations are stored in chunks
+ * which never move, and IDs are found in a hash table which is replaced,
+ * not rehashed in place, when it fills up. */
+
+class MutationTable
+{
+public:
+	static MutationTable *table();
+
+	int intern(const Mutation &m);
+
+	/* -1 if this mutation has never been seen */
+	int find(const Mutation &m);
+	Mutation mutation(int id);
+	size_t size();
+private:
+	MutationTable();
+
+	typedef struct
+	{
+		std::atomic<uint64_t> key;
+		std::atomic<int> id;
+	} Slot;
+
+	typedef struct
+	{
+		size_t capacity;
+		Slot *entries;
+	} Lookup;
+
+	static const int _chunkBits = 12;
+	static const int _maxChunks = 1 << 14;
+
+	static uint64_t key(const Mutation &m);
+	static int search(const Lookup *lookup, uint64_t key);
+	static void place(Lookup *lookup, uint64_t key, int id);
+	void grow();
+
+	std::atomic<Mutation *> _chunks[_maxChunks];
+	std::atomic<size_t> _size;
+	std::atomic<Lookup *> _lookup;
+
+	/* replaced lookups, kept for any readers still searching them */
+	std::vector<Lookup *> _retired;
+	std::mutex _mutex;
+};
+
+#endif
@@ -0,0 +1,241 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "MutationHistogram.h"
+#include <algorithm>
+#include <climits>
+
+MutationHistogram::MutationHistogram()
+{
+	_start = 0;
+}
+
+int MutationHistogram::slot(char alt)
+{
+	if (alt >= 'A' && alt <= 'Z')
+	{
+		return alt - 'A';
+	}
+
+	switch (alt)
+	{
+		case '+':
+		return 26;
+		case '-':
+		return 27;
+		case '>':
+		return 28;
+		case '<':
+		return 29;
+		default:
+		return 30;
+	}
+}
+
+void MutationHistogram::clear()
+{
+	_start = 0;
+	_totals.clear();
+	_counters.clear();
+}
+
+/* grows the dense range to include this residue */
+void MutationHistogram::cover(int resi)
+{
+	if (_totals.size() == 0)
+	{
+		_start = resi;
+	}
+
+	if (contains(resi))
+	{
+		return;
+	}
+
+	int start = std::min(_start, resi);
+	int end = std::max(_start + (int)_totals.size(), resi + 1);
+
+	Counter empty;
+	empty.count = 0;
+	empty.first = ULONG_MAX;
+	empty.ref = '\0';
+	empty.alt = '\0';
+
+	std::vector<int> totals(end - start, 0);
+	std::vector<Counter> counters((end - start) * _slots, empty);
+	
+	for (size_t i = 0; i < _totals.size(); i++)
+	{
+		size_t to = i + _start - start;
+		totals[to] = _totals[i];
+
+		for (int j = 0; j < _slots; j++)
+		{
+			counters[to * _slots + j] = _counters[i * _slots + j];
+		}
+	}
+	
+	_start = start;
+	_totals.swap(totals);
+	_counters.swap(counters);
+}
+
+void MutationHistogram::add(const Mutation &m, unsigned long order, 
+                            int weight)
+{
+	cover(m.resi);
+	
+	int i = m.resi - _start;
+	Counter &c = _counters[i * _slots + slot(m.alt)];
+	c.count += weight;
+	_totals[i] += weight;
+
+	if (order < c.first)
+	{
+		c.first = order;
+		c.ref = m.ref;
+		c.alt = m.alt;
+	}
+}
+
+void MutationHistogram::remove(const Mutation &m)
+{
+	if (!contains(m.resi))
+	{
+		return;
+	}
+
+	int i = m.resi - _start;
+	Counter &c = _counters[i * _slots + slot(m.alt)];
+	
+	if (c.count == 0)
+	{
+		return;
+	}
+
+	c.count--;
+	_totals[i]--;
+	
+	if (c.count == 0)
+	{
+		c.first = ULONG_MAX;
+	}
+}
+
+void MutationHistogram::merge(const MutationHistogram &other,
+                              unsigned long offset)
+{
+	if (other._totals.size() == 0)
+	{
+		return;
+	}
+
+	cover(other._start);
+	cover(other._start + other._totals.size() - 1);
+	
+	for (size_t i = 0; i < other._totals.size(); i++)
+	{
+		size_t to = i + other._start - _start;
+		_totals[to] += other._totals[i];
+
+		for (int j = 0; j < _slots; j++)
+		{
+			const Counter &theirs = other._counters[i * _slots + j];
+			Counter &mine = _counters[to * _slots + j];
+			mine.count += theirs.count;
+
+			if (theirs.count > 0 && theirs.first + offset < mine.first)
+			{
+				mine.first = theirs.first + offset;
+				mine.ref = theirs.ref;
+				mine.alt = theirs.alt;
+			}
+		}
+	}
+}
+
+int MutationHistogram::total(int resi) const
+{
+	if (!contains(resi))
+	{
+		return 0;
+	}
+
+	return _totals[resi - _start];
+}
+
+std::string MutationHistogram::alts(int resi) const
+{
+	std::string aas;
+
+	if (total(resi) == 0)
+	{
+		return aas;
+	}
+	
+	const Counter *c = counters(resi);
+	std::vector<const Counter *> seen;
+
+	for (int j = 0; j < _slots; j++)
+	{
+		if (c[j].count > 0)
+		{
+			seen.push_back(&c[j]);
+		}
+	}
+	
+	/* a handful at most, so sort by insertion */
+	for (size_t i = 1; i < seen.size(); i++)
+	{
+		for (size_t j = i; j > 0 && seen[j]->first < seen[j - 1]->first; j--)
+		{
+			std::swap(seen[j], seen[j - 1]);
+		}
+	}
+
+	for (size_t i = 0; i < seen.size(); i++)
+	{
+		if (aas.find(seen[i]->alt) == std::string::npos)
+		{
+			aas.push_back(seen[i]->alt);
+		}
+	}
+
+	return aas;
+}
+
+char MutationHistogram::reference(int resi) const
+{
+	if (total(resi) == 0)
+	{
+		return '\0';
+	}
+
+	const Counter *c = counters(resi);
+	const Counter *best = NULL;
+
+	for (int j = 0; j < _slots; j++)
+	{
+		if (c[j].count > 0 && (best == NULL || c[j].first < best->first))
+		{
+			best = &c[j];
+		}
+	}
+
+	return best->ref;
+}
@@ -0,0 +1,83 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__mutationhistogram__
+#define __breathalyser__mutationhistogram__
+
+#include <string>
+#include <vector>
+#include "Mutation.h"
+
+/* counts of each replacement at each residue, held densely over the range
+ * of residues seen so far. Every mutation is given the order of the
+ * sequence it came from, so that replacements can be listed in the order
+ * they were first seen even when histograms are filled separately and 
+ * merged. */
+
+class MutationHistogram
+{
+public:
+	MutationHistogram();
+
+	/* weight counts the mutation as seen that many times at once */
+	void add(const Mutation &m, unsigned long order, int weight = 1);
+	void remove(const Mutation &m);
+
+	/* other's mutations are taken as seen after any whose order is below
+	 * the offset */
+	void merge(const MutationHistogram &other, unsigned long offset = 0);
+	void clear();
+
+	/* number of mutations at this residue */
+	int total(int resi) const;
+	
+	/* replacements at this residue, in the order first seen */
+	std::string alts(int resi) const;
+
+	/* reference amino acid of the first mutation seen at this residue */
+	char reference(int resi) const;
+private:
+	typedef struct
+	{
+		int count;
+		unsigned long first;
+		char ref;
+		char alt;
+	} Counter;
+
+	static const int _slots = 31;
+	static int slot(char alt);
+
+	void cover(int resi);
+	
+	const Counter *counters(int resi) const
+	{
+		return &_counters[(resi - _start) * _slots];
+	}
+
+	bool contains(int resi) const
+	{
+		return (resi >= _start && resi < _start + (int)_totals.size());
+	}
+
+	int _start;
+	std::vector<int> _totals;
+	std::vector<Counter> _counters;
+};
+
+#endif
@@ -0,0 +1,84 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "MutationIndex.h"
+#include "Fasta.h"
+
+MutationIndex::MutationIndex() : FastaListCache()
+{
+
+}
+
+void MutationIndex::update(const std::vector<Fasta *> &fastas)
+{
+	if (!stale(fastas))
+	{
+		return;
+	}
+
+	_byResidue.clear();
+	_byMutation.clear();
+
+	for (size_t i = 0; i < _fastas.size(); i++)
+	{
+		Fasta *f = _fastas[i];
+
+		for (size_t j = 0; j < f->mutationCount(); j++)
+		{
+			const Mutation &m = f->mutation(j);
+			std::vector<int> &res = _byResidue[m.resi];
+			std::vector<int> &mut = _byMutation[key(m.resi, m.alt)];
+
+			/* positions only ever increase, so this keeps them unique */
+			if (res.size() == 0 || res.back() != (int)i)
+			{
+				res.push_back(i);
+			}
+
+			if (mut.size() == 0 || mut.back() != (int)i)
+			{
+				mut.push_back(i);
+			}
+		}
+	}
+}
+
+const std::vector<int> &MutationIndex::withResidue(int resi)
+{
+	std::map<int, std::vector<int> >::iterator it = _byResidue.find(resi);
+
+	if (it == _byResidue.end())
+	{
+		return _empty;
+	}
+	
+	return it->second;
+}
+
+const std::vector<int> &MutationIndex::withMutation(int resi, char alt)
+{
+	std::map<long long, std::vector<int> >::iterator it;
+	it = _byMutation.find(key(resi, alt));
+
+	if (it == _byMutation.end())
+	{
+		return _empty;
+	}
+	
+	return it->second;
+}
@@ -0,0 +1,65 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__mutationindex__
+#define __breathalyser__mutationindex__
+
+#include <string>
+#include <vector>
+#include <map>
+#include "FastaListCache.h"
+
+class Fasta;
+
+/* inverted index from residue, and from residue with replacement, to the
+ * positions of the sequences carrying them, in the order of the list it
+ * was built from. */
+
+class MutationIndex : public FastaListCache
+{
+public:
+	MutationIndex();
+
+	void update(const std::vector<Fasta *> &fastas);
+
+	size_t size()
+	{
+		return _fastas.size();
+	}
+	
+	Fasta *fasta(int i)
+	{
+		return _fastas[i];
+	}
+
+	/* sorted positions of the sequences with any change at this residue */
+	const std::vector<int> &withResidue(int resi);
+	const std::vector<int> &withMutation(int resi, char alt);
+private:
+	static long long key(int resi, char alt)
+	{
+		return (long long)resi * 256 + (unsigned char)alt;
+	}
+
+
+	std::map<int, std::vector<int> > _byResidue;
+	std::map<long long, std::vector<int> > _byMutation;
+	std::vector<int> _empty;
+};
+
+#endif
@@ -19,7 +19,9 @@
 #include "Main.h"
 #include "MyDictator.h"
 #include "FastaMaster.h"
+#include "FastaGroup.h"
 #include "Fasta.h"
+#include "AlignmentCache.h"
 #include "LoadStructure.h"
 #include "LoadFastas.h"
 #include <iostream>
@@ -84,6 +86,15 @@ bool MyDictator::processRequest(std::string first, std::string last)
 	{
 		_main->fMaster()->writeOutMutations(last);
 	}
+	if (first == "co-occurrence")
+	{
+		/* e.g. 400-500,matrix.csv */
+		std::vector<std::string> bits = split(last, ',');
+		if (bits.size() == 2)
+		{
+			_main->fMaster()->mutationScan2D(bits[0], bits[1]);
+		}
+	}
 	if (first == "clear-fastas")
 	{
 		_main->fMaster()->clear();
@@ -97,6 +108,22 @@ bool MyDictator::processRequest(std::string first, std::string last)
 	{
 		Fasta::setJustify(true);
 	}
+	if (first == "full-alignment")
+	{
+		Fasta::setBanded(false);
+	}
+	if (first == "load-alignment-cache")
+	{
+		AlignmentCache::cache()->load(last);
+	}
+	if (first == "save-alignment-cache")
+	{
+		AlignmentCache::cache()->save(last);
+	}
+	if (first == "cluster-limit")
+	{
+		FastaGroup::setClusterLimit(atoi(last.c_str()));
+	}
 	if (first == "order-by")
 	{
 		_main->fMaster()->reorderBy(last);
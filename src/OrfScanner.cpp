@@ -0,0 +1,72 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "OrfScanner.h"
+#include "Translation.h"
+
+OrfScanner::OrfScanner(const std::string &seq)
+{
+	int length = seq.length();
+	_orfCount = 0;
+
+	for (size_t i = 0; i < 3; i++)
+	{
+		_lastStop[i] = -1;
+		_frames[i] = translate_sequence(seq, i, length);
+	}
+
+	for (int i = 0; i + 3 <= length; i++)
+	{
+		char aa = _frames[i % 3][i / 3];
+
+		if (aa == 'M' && i < length - 3)
+		{
+			_atgs.push_back(i);
+		}
+		else if (aa == ' ')
+		{
+			const char *codon = &seq[i];
+
+			if (codon[0] == 'T' && ((codon[1] == 'A' && codon[2] == 'A') ||
+			                        (codon[1] == 'A' && codon[2] == 'G') ||
+			                        (codon[1] == 'G' && codon[2] == 'A')))
+			{
+				_lastStop[i % 3] = i;
+			}
+		}
+	}
+	
+	for (size_t i = 0; i < _atgs.size(); i++)
+	{
+		if (stop(i) <= start(i) + 3)
+		{
+			break;
+		}
+
+		_orfCount++;
+	}
+}
+
+std::string OrfScanner::protein(int i)
+{
+	int frame = start(i) % 3;
+	int first = start(i) / 3;
+	int last = stop(i) / 3;
+
+	return _frames[frame].substr(first, last - first + 1);
+}
@@ -0,0 +1,59 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__orfscanner__
+#define __breathalyser__orfscanner__
+
+#include <string>
+#include <vector>
+
+/* indexes every ATG and stop codon of a nucleotide sequence in one pass
+ * and translates all three frames once. Candidate ORFs run from each ATG
+ * (in order along the sequence) to the last stop codon in the same frame,
+ * and their proteins are cut out of the frame translations. */
+
+class OrfScanner
+{
+public:
+	OrfScanner(const std::string &seq);
+	
+	/* candidates end at the first ATG with no stop codon after it */
+	size_t orfCount()
+	{
+		return _orfCount;
+	}
+	
+	int start(int i)
+	{
+		return _atgs[i];
+	}
+	
+	int stop(int i)
+	{
+		return _lastStop[_atgs[i] % 3];
+	}
+
+	std::string protein(int i);
+private:
+	std::vector<int> _atgs;
+	int _lastStop[3];
+	std::string _frames[3];
+	size_t _orfCount;
+};
+
+#endif
@@ -0,0 +1,208 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "Requirements.h"
+#include "MutationIndex.h"
+#include "Fasta.h"
+#include <hcsrc/FileReader.h>
+#include <algorithm>
+#include <iterator>
+#include <cstdlib>
+
+Requirements::Requirements(std::string text)
+{
+	_text = text;
+	text.erase(std::remove(text.begin(), text.end(), ' '), text.end());
+
+	std::vector<std::string> terms = split(text, ',');
+	
+	for (size_t i = 0; i < terms.size(); i++)
+	{
+		std::vector<std::string> options = split(terms[i], '|');
+		Clause clause;
+
+		for (size_t j = 0; j < options.size(); j++)
+		{
+			clause.push_back(compileTerm(options[j]));
+		}
+		
+		if (clause.size())
+		{
+			_clauses.push_back(clause);
+		}
+	}
+}
+
+Requirements::Term Requirements::compileTerm(std::string str)
+{
+	Term t;
+	t.invert = false;
+	
+	if (str.length() && str[0] == '!')
+	{
+		str.erase(str.begin());
+		t.invert = true;
+	}
+
+	/* reference amino acid is optional */
+	if (str.length() && (str[0] < '0' || str[0] > '9'))
+	{
+		str.erase(str.begin());
+	}
+
+	const char *begin = str.c_str();
+	char *end = NULL;
+	t.start = strtol(begin, &end, 10);
+	t.end = t.start;
+	t.valid = (end != begin);
+	
+	/* a range, rather than a deletion, if a number follows */
+	if (t.valid && end[0] == '-' && end[1] >= '0' && end[1] <= '9')
+	{
+		begin = end + 1;
+		t.end = strtol(begin, &end, 10);
+	}
+
+	t.alt = *end;
+
+	return t;
+}
+
+bool Requirements::isValid() const
+{
+	for (size_t i = 0; i < _clauses.size(); i++)
+	{
+		for (size_t j = 0; j < _clauses[i].size(); j++)
+		{
+			if (!_clauses[i][j].valid)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool Requirements::termMatches(const Term &t, Fasta *f)
+{
+	bool found = false;
+
+	for (size_t i = 0; t.valid && i < f->mutationCount(); i++)
+	{
+		const Mutation &m = f->mutation(i);
+
+		if (m.resi >= t.start && m.resi <= t.end && 
+		    (t.alt == '\0' || t.alt == m.alt))
+		{
+			found = true;
+			break;
+		}
+	}
+	
+	return (found != t.invert);
+}
+
+bool Requirements::matches(Fasta *f) const
+{
+	for (size_t i = 0; i < _clauses.size(); i++)
+	{
+		bool any = false;
+
+		for (size_t j = 0; j < _clauses[i].size() && !any; j++)
+		{
+			any = termMatches(_clauses[i][j], f);
+		}
+		
+		if (!any)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+std::vector<int> Requirements::termSelect(const Term &t, MutationIndex &index)
+{
+	std::vector<int> found;
+
+	for (int r = t.start; t.valid && r <= t.end; r++)
+	{
+		const std::vector<int> &list = (t.alt == '\0' ? index.withResidue(r) :
+		                                 index.withMutation(r, t.alt));
+		
+		if (list.size() == 0)
+		{
+			continue;
+		}
+
+		std::vector<int> merged;
+		std::set_union(found.begin(), found.end(), list.begin(), list.end(),
+		               std::back_inserter(merged));
+		found.swap(merged);
+	}
+	
+	if (!t.invert)
+	{
+		return found;
+	}
+
+	std::vector<int> all, missing;
+	for (size_t i = 0; i < index.size(); i++)
+	{
+		all.push_back(i);
+	}
+
+	std::set_difference(all.begin(), all.end(), found.begin(), found.end(),
+	                    std::back_inserter(missing));
+
+	return missing;
+}
+
+std::vector<int> Requirements::select(MutationIndex &index) const
+{
+	std::vector<int> results;
+
+	for (size_t i = 0; i < index.size(); i++)
+	{
+		results.push_back(i);
+	}
+
+	for (size_t i = 0; i < _clauses.size() && results.size(); i++)
+	{
+		std::vector<int> any;
+
+		for (size_t j = 0; j < _clauses[i].size(); j++)
+		{
+			std::vector<int> list = termSelect(_clauses[i][j], index);
+			std::vector<int> merged;
+			std::set_union(any.begin(), any.end(), list.begin(), list.end(),
+			               std::back_inserter(merged));
+			any.swap(merged);
+		}
+
+		std::vector<int> next;
+		std::set_intersection(results.begin(), results.end(), 
+		                      any.begin(), any.end(),
+		                      std::back_inserter(next));
+		results.swap(next);
+	}
+
+	return results;
+}
@@ -0,0 +1,77 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__requirements__
+#define __breathalyser__requirements__
+
+#include <string>
+#include <vector>
+
+class Fasta;
+class MutationIndex;
+
+/* requirement string compiled once, then checked against any number of
+ * sequences without string work. Terms separated by ',' must all hold,
+ * and alternatives within a term are separated by '|'. Each alternative
+ * is an optional '!', an optional reference amino acid, a residue or a
+ * range of residues, and an optional replacement, e.g. 
+ * "N501Y,E484K|E484Q,!417" or "!400-500". */
+
+class Requirements
+{
+public:
+	Requirements(std::string text = "");
+
+	const std::string &text() const
+	{
+		return _text;
+	}
+	
+	bool isEmpty() const
+	{
+		return _clauses.size() == 0;
+	}
+
+	/* false if any alternative could not be read */
+	bool isValid() const;
+
+	bool matches(Fasta *f) const;
+	
+	/* sorted positions of every sequence in the index which match */
+	std::vector<int> select(MutationIndex &index) const;
+private:
+	typedef struct
+	{
+		int start;
+		int end;
+		char alt;
+		bool invert;
+		bool valid;
+	} Term;
+
+	typedef std::vector<Term> Clause;
+
+	static Term compileTerm(std::string str);
+	static bool termMatches(const Term &t, Fasta *f);
+	static std::vector<int> termSelect(const Term &t, MutationIndex &index);
+
+	std::string _text;
+	std::vector<Clause> _clauses;
+};
+
+#endif
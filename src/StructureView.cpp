@@ -18,12 +18,13 @@
 
 #include <iostream>
 #include <QMenu>
-#include <h3dsrc/Text.h>
 #include <hcsrc/FileReader.h>
 #include "StructureView.h"
+#include "LabelBatch.h"
 #include "Ensemble.h"
 #include "Segment.h"
 #include "FastaMaster.h"
+#include "Requirements.h"
 #include "Main.h"
 
 StructureView::StructureView(QWidget *parent) : SlipGL(parent)
@@ -32,7 +33,7 @@ StructureView::StructureView(QWidget *parent) : SlipGL(parent)
 	setBackground(1, 1, 1, 1);
 	setZFar(2000.);
 	setFocusPolicy(Qt::ClickFocus);
-	_text = NULL;
+	_caption = NULL;
 	_ensemble = NULL;
 }
 
@@ -62,24 +63,17 @@ void StructureView::addEnsemble(Ensemble *e)
 	}
 }
 
+/* frame captions share the glyph atlas, so a new one only rewrites the
+ * caption's vertices */
 void StructureView::addLabel(std::string str)
 {
-	Text *text = new Text();
-	text->setProperties(_centre, str, 72, Qt::black,
-	                    0, -33, -20);
-	text->prepare();
-	setText(text);
-}
-
-void StructureView::setText(Text *text)
-{
-	removeObject(_text);
-	delete _text;
-	_text = text;
-	if (text)
+	if (_caption == NULL)
 	{
-		addObject(text, false);
+		_caption = new LabelBatch(0.025, make_vec3(0, -33, -20));
+		addObject(_caption, false);
 	}
+
+	_caption->setLabel(0, _centre, str);
 }
 
 void StructureView::clickMouse(double x, double y)
@@ -112,9 +106,10 @@ void StructureView::mouseReleaseEvent(QMouseEvent *e)
 void StructureView::makeMutationMenu(QPoint &p)
 {
 	std::string resi = _ensemble->selectedMutation();
-	std::string inverse = "!" + resi;
+	Requirements mutant(resi);
+	Requirements wildType("!" + resi);
 
-	if (resi.length() == 0)
+	if (resi.length() == 0 || !mutant.isValid())
 	{
 		return;
 	}
@@ -122,10 +117,10 @@ void StructureView::makeMutationMenu(QPoint &p)
 	QMenu *m = new QMenu();
 	QAction *act = m->addAction("Select on mutation");
 	connect(act, &QAction::triggered, 
-	        this, [=] {_main->fMaster()->requireMutation(resi);});
+	        this, [=] {_main->fMaster()->requireMutation(mutant);});
 	act = m->addAction("Select on wild-type");
 	connect(act, &QAction::triggered, 
-	        this, [=] {_main->fMaster()->requireMutation(inverse);});
+	        this, [=] {_main->fMaster()->requireMutation(wildType);});
 	m->exec(p);
 }
 
@@ -24,7 +24,7 @@
 
 class Main;
 class Ensemble;
-class Text;
+class LabelBatch;
 
 class StructureView : public SlipGL
 {
@@ -32,7 +32,6 @@ public:
 	StructureView(QWidget *parent);
 	void addEnsemble(Ensemble *e);
 	
-	void setText(Text *text);
 	void addLabel(std::string string);
 	
 	void setMain(Main *main)
@@ -50,7 +49,7 @@ protected:
 private:
 	Main *_main;
 	Ensemble *_ensemble;
-	Text *_text;
+	LabelBatch *_caption;
 	vec3 _centre;
 	bool _centreSet;
 
@@ -0,0 +1,123 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#include "Translation.h"
+
+/* standard genetic code in the order AAA, AAC, AAG, AAT, ACA ... TTT */
+static const char _geneticCode[] = "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLL"
+                                   "EDEDAAAAGGGGVVVV Y YSSSS CWCLFLF";
+
+/* codons are looked up with three 3-bit nucleotide codes, so that a code
+ * of 4 (unknown) lands on a ' ' entry without needing a branch */
+typedef struct CodonTable
+{
+	CodonTable()
+	{
+		for (size_t i = 0; i < 256; i++)
+		{
+			codes[i] = 4;
+		}
+
+		codes['A'] = 0;
+		codes['C'] = 1;
+		codes['G'] = 2;
+		codes['T'] = 3;
+		
+		for (size_t i = 0; i < 512; i++)
+		{
+			size_t a = (i >> 6) & 7;
+			size_t b = (i >> 3) & 7;
+			size_t c = i & 7;
+			
+			if (a > 3 || b > 3 || c > 3)
+			{
+				aas[i] = ' ';
+				continue;
+			}
+
+			aas[i] = _geneticCode[a * 16 + b * 4 + c];
+		}
+	}
+
+	unsigned char codes[256];
+	char aas[512];
+} CodonTable;
+
+static const CodonTable _table;
+
+inline size_t codon_index(const unsigned char *nt)
+{
+	return ((size_t)_table.codes[nt[0]] << 6 | 
+	        (size_t)_table.codes[nt[1]] << 3 | 
+	        (size_t)_table.codes[nt[2]]);
+}
+
+unsigned char nucleotide_code(char nt)
+{
+	return _table.codes[(unsigned char)nt];
+}
+
+char translate_codon(const char *codon)
+{
+	return _table.aas[codon_index((const unsigned char *)codon)];
+}
+
+std::string translate_sequence(const std::string &nt, int start, int end)
+{
+	if (start < 0 || end <= start)
+	{
+		return "";
+	}
+
+	size_t total = (end - start + 2) / 3;
+	std::string aa(total, ' ');
+
+	/* only whole codons which lie inside the sequence */
+	size_t whole = 0;
+	if ((int)nt.length() > start)
+	{
+		whole = (nt.length() - start) / 3;
+	}
+	
+	if (whole > total)
+	{
+		whole = total;
+	}
+
+	const unsigned char *ptr = (const unsigned char *)&nt[start];
+	char *out = &aa[0];
+	size_t i = 0;
+
+	/* four codons at a time for long open reading frames */
+	for (; i + 4 <= whole; i += 4)
+	{
+		out[i]     = _table.aas[codon_index(ptr)];
+		out[i + 1] = _table.aas[codon_index(ptr + 3)];
+		out[i + 2] = _table.aas[codon_index(ptr + 6)];
+		out[i + 3] = _table.aas[codon_index(ptr + 9)];
+		ptr += 12;
+	}
+	
+	for (; i < whole; i++)
+	{
+		out[i] = _table.aas[codon_index(ptr)];
+		ptr += 3;
+	}
+
+	return aa;
+}
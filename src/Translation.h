@@ -0,0 +1,35 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__translation__
+#define __breathalyser__translation__
+
+#include <string>
+
+/* 2-bit code for A, C, G, T (0-3), or 4 for anything untranslatable */
+unsigned char nucleotide_code(char nt);
+
+/* amino acid for the three nucleotides at codon, or ' ' for stop codons
+ * and anything containing an unknown nucleotide */
+char translate_codon(const char *codon);
+
+/* translates codons starting at start, up to (not including) end;
+ * an incomplete codon at the end of the sequence becomes ' ' */
+std::string translate_sequence(const std::string &nt, int start, int end);
+
+#endif
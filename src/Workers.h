@@ -0,0 +1,156 @@
+// breathalyser
+// Copyright (C) 2019 Helen Ginn
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+// Please email: vagabond @ hginn.co.uk for more details.
+
+#ifndef __breathalyser__workers__
+#define __breathalyser__workers__
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+
+inline size_t worker_count()
+{
+	size_t n = std::thread::hardware_concurrency();
+	
+	if (n == 0)
+	{
+		n = 1;
+	}
+
+	return n;
+}
+
+/* polled by long jobs which may be abandoned part way through */
+typedef std::function<bool ()> CancelCheck;
+
+inline bool never_cancelled()
+{
+	return false;
+}
+
+/* calls job(i, t) for every i in [0, count) across all the cores, where t
+ * is the index of the worker thread (for per-thread scratch space).
+ * Jobs are handed out in order but finish in any order, so each one must
+ * only write to its own results. Returns once every job is done. */
+
+template <class Job>
+void parallel_for(size_t count, Job job, bool progress = false)
+{
+	size_t threads = worker_count();
+
+	if (threads > count)
+	{
+		threads = count;
+	}
+
+	std::atomic<size_t> next(0);
+	std::atomic<size_t> done(0);
+	size_t per_stage = count / 100 + 1;
+
+	auto work = [&](size_t t)
+	{
+		while (true)
+		{
+			size_t i = next++;
+
+			if (i >= count)
+			{
+				break;
+			}
+
+			job(i, t);
+			
+			if (progress && (++done % per_stage) == 0)
+			{
+				std::cout << "." << std::flush;
+			}
+		}
+	};
+
+	std::vector<std::thread> pool;
+
+	for (size_t t = 1; t < threads; t++)
+	{
+		pool.push_back(std::thread(work, t));
+	}
+	
+	if (threads > 0)
+	{
+		work(0);
+	}
+
+	for (size_t t = 0; t < pool.size(); t++)
+	{
+		pool[t].join();
+	}
+	
+	if (progress)
+	{
+		std::cout << std::endl;
+	}
+}
+
+/* stable sort of items in a chunk per core, with the sorted chunks then
+ * merged pairwise, also in parallel */
+
+template <class T, class Compare>
+void parallel_sort(std::vector<T> &items, Compare comp)
+{
+	size_t chunks = worker_count();
+
+	if (items.size() < chunks * 1024)
+	{
+		std::stable_sort(items.begin(), items.end(), comp);
+		return;
+	}
+	
+	std::vector<size_t> bounds;
+	for (size_t c = 0; c <= chunks; c++)
+	{
+		bounds.push_back(items.size() * c / chunks);
+	}
+
+	typename std::vector<T>::iterator begin = items.begin();
+
+	parallel_for(chunks, [&](size_t c, size_t)
+	{
+		std::stable_sort(begin + bounds[c], begin + bounds[c + 1], comp);
+	});
+	
+	for (size_t width = 1; width < chunks; width *= 2)
+	{
+		std::vector<size_t> firsts;
+		for (size_t c = 0; c + width < chunks; c += 2 * width)
+		{
+			firsts.push_back(c);
+		}
+
+		parallel_for(firsts.size(), [&](size_t i, size_t)
+		{
+			size_t c = firsts[i];
+			size_t end = std::min(c + 2 * width, chunks);
+			std::inplace_merge(begin + bounds[c], begin + bounds[c + width],
+			                   begin + bounds[end], comp);
+		});
+	}
+}
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef __Label_fsh__
+#define __Label_fsh__
+
+inline std::string Label_fsh() 
+{
+	std::string str = 
+	"varying vec4 vColor;\n"\
+	"varying vec2 vTex;\n"\
+	"\n"\
+	"uniform sampler2D pic_tex;\n"\
+	"\n"\
+	"void main()\n"\
+	"{\n"\
+	"	float alpha = texture2D(pic_tex, vTex)[3];\n"\
+	"\n"\
+	"	if (alpha < 0.05)\n"\
+	"	{\n"\
+	"		discard;\n"\
+	"	}\n"\
+	"\n"\
+	"	gl_FragColor = vec4(vColor[0], vColor[1], vColor[2], alpha);\n"\
+	"}\n";
+	return str;
+}
+
+#endif
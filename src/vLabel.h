@@ -0,0 +1,36 @@
+#ifndef __Label_vsh__
+#define __Label_vsh__
+
+/* glyph quads stay facing the screen at a fixed size: each corner is 
+ * placed at its label's anchor, then moved by extra.xy (in glyph heights)
+ * times extra.z (glyph height on screen) after projection */
+
+inline std::string Label_vsh()
+{
+	std::string str = 
+	"attribute vec3 normal;\n"\
+	"attribute vec3 position;\n"\
+	"attribute vec4 color;\n"\
+	"attribute vec4 extra;\n"\
+	"attribute vec2 tex;\n"\
+	"\n"\
+	"uniform mat4 model;\n"\
+	"uniform mat4 projection;\n"\
+	"\n"\
+	"varying vec4 vColor;\n"\
+	"varying vec4 vPos;\n"\
+	"varying vec2 vTex;\n"\
+	"\n"\
+	"void main()\n"\
+	"{\n"\
+	"    vec4 pos = vec4(position[0], position[1], position[2], 1.0);\n"\
+	"    vPos = projection * model * pos;\n"\
+	"    vPos.xy += extra.xy * extra.z * vPos.w;\n"\
+	"    gl_Position = vPos;\n"\
+	"    vColor = color;\n"\
+	"    vTex = tex;\n"\
+	"}";
+	return str;
+}
+
+#endif